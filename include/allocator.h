@@ -0,0 +1,156 @@
+#pragma once
+
+#include "base.h"
+
+class MemoryAllocatorVK final
+{
+public:
+   // How the host accesses a resource, which decides the memory type it is placed in. Staging buffers are written once
+   // and copied from, while CpuToGpu buffers are rewritten every frame and read by shaders directly.
+   enum class Usage { GpuOnly, Staging, CpuToGpu, GpuToCpu };
+
+   struct Allocation
+   {
+      VkDeviceMemory Memory;
+      VkDeviceSize Offset;
+      VkDeviceSize Size;
+      uint32_t MemoryTypeIndex;
+      uint32_t PoolIndex;
+      void* MappedData;
+      bool Dedicated;
+
+      Allocation() :
+         Memory( VK_NULL_HANDLE ), Offset( 0 ), Size( 0 ), MemoryTypeIndex( 0 ), PoolIndex( 0 ), MappedData( nullptr ),
+         Dedicated( false ) {}
+      [[nodiscard]] bool isValid() const { return Memory != VK_NULL_HANDLE; }
+   };
+
+   struct Statistics
+   {
+      uint32_t BlockCount;
+      uint32_t DedicatedAllocationCount;
+      uint32_t AllocationCount;
+      uint32_t FreeRangeCount;
+      VkDeviceSize BlockBytes;
+      VkDeviceSize DedicatedBytes;
+      VkDeviceSize UsedBytes;
+      VkDeviceSize LargestFreeRange;
+
+      Statistics() :
+         BlockCount( 0 ), DedicatedAllocationCount( 0 ), AllocationCount( 0 ), FreeRangeCount( 0 ), BlockBytes( 0 ),
+         DedicatedBytes( 0 ), UsedBytes( 0 ), LargestFreeRange( 0 ) {}
+
+      // 0 when all free space in the blocks is one contiguous range, approaching 1 as it splinters.
+      [[nodiscard]] float getFragmentation() const
+      {
+         const VkDeviceSize free_bytes = BlockBytes - UsedBytes;
+         if (free_bytes == 0) return 0.0f;
+         return 1.0f - static_cast<float>(LargestFreeRange) / static_cast<float>(free_bytes);
+      }
+   };
+
+   // Usage is what this process has allocated from a heap, and budget is how much it can allocate there before the
+   // system starts paging or failing allocations.
+   struct HeapBudget
+   {
+      VkDeviceSize Usage;
+      VkDeviceSize Budget;
+      VkDeviceSize Size;
+
+      HeapBudget() : Usage( 0 ), Budget( 0 ), Size( 0 ) {}
+   };
+
+   MemoryAllocatorVK(VkPhysicalDevice physical_device, VkDevice device, bool memory_budget_supported);
+   ~MemoryAllocatorVK();
+
+   [[nodiscard]] uint32_t findMemoryType(uint32_t type_filter, Usage usage) const;
+   void benchmarkMemoryTypes(std::ostream& stream);
+
+   [[nodiscard]] Allocation allocate(
+      const VkMemoryRequirements& requirements,
+      uint32_t memory_type_index,
+      bool linear_resource
+   );
+   void free(Allocation& allocation);
+
+   // Used by the defragmenter: how full the block of an allocation is, and a new place for an allocation that is about
+   // to move, taken only from blocks of the same pool that are fuller than its own so that moves always compact memory.
+   // Returns an invalid allocation when none of them has room.
+   [[nodiscard]] float getBlockOccupancy(const Allocation& allocation) const;
+   [[nodiscard]] Allocation allocateForMove(const VkMemoryRequirements& requirements, const Allocation& source);
+   [[nodiscard]] Statistics getStatistics() const;
+   void printStatistics(std::ostream& stream) const;
+   [[nodiscard]] std::vector<HeapBudget> getHeapBudgets();
+   void printHeapBudgets(std::ostream& stream);
+
+private:
+   struct Block
+   {
+      VkDeviceMemory Memory;
+      VkDeviceSize Size;
+      void* MappedData;
+      uint32_t AllocationCount;
+      std::map<VkDeviceSize, VkDeviceSize> FreeRanges;
+
+      Block() : Memory( VK_NULL_HANDLE ), Size( 0 ), MappedData( nullptr ), AllocationCount( 0 ) {}
+   };
+
+   inline static constexpr VkDeviceSize DefaultBlockSize = 64ull * 1024 * 1024;
+   inline static constexpr VkDeviceSize SmallHeapSize = 1024ull * 1024 * 1024;
+   inline static constexpr VkDeviceSize BenchmarkSize = 16ull * 1024 * 1024;
+   inline static constexpr uint32_t BudgetFetchInterval = 30;
+
+   // Host bandwidth in bytes per second, measured by benchmarkMemoryTypes() and 0 otherwise.
+   struct Bandwidth
+   {
+      double Write;
+      double Read;
+
+      Bandwidth() : Write( 0.0 ), Read( 0.0 ) {}
+   };
+
+   VkPhysicalDevice PhysicalDevice;
+   VkDevice Device;
+   VkPhysicalDeviceMemoryProperties MemoryProperties;
+   VkDeviceSize BufferImageGranularity;
+   std::vector<Bandwidth> Bandwidths;
+
+   // Pools are indexed by (memory type, linear/optimal) so that linear and non-linear resources never share a block,
+   // which keeps every sub-allocation clear of bufferImageGranularity conflicts without per-neighbor checks.
+   std::vector<std::vector<std::unique_ptr<Block>>> Pools;
+   uint32_t DedicatedAllocationCount;
+   VkDeviceSize DedicatedBytes;
+
+   // Bytes of VkDeviceMemory allocated per heap. With VK_EXT_memory_budget, the driver's numbers are only fetched every
+   // few allocations, and the usage in between is extrapolated from how much these counts changed since the fetch.
+   bool MemoryBudgetSupported;
+   uint32_t OperationsSinceBudgetFetch;
+   std::vector<VkDeviceSize> HeapAllocatedBytes;
+   std::vector<VkDeviceSize> HeapAllocatedBytesAtFetch;
+   std::vector<VkDeviceSize> FetchedHeapUsage;
+   std::vector<VkDeviceSize> FetchedHeapBudget;
+
+   // Resources are created from the upload thread as well as from the rendering thread.
+   mutable std::mutex Mutex;
+
+   [[nodiscard]] VkDeviceSize getPreferredBlockSize(uint32_t memory_type_index) const;
+   [[nodiscard]] bool isHostVisible(uint32_t memory_type_index) const
+   {
+      return (MemoryProperties.memoryTypes[memory_type_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+   }
+   [[nodiscard]] uint32_t getHeapIndex(uint32_t memory_type_index) const
+   {
+      return MemoryProperties.memoryTypes[memory_type_index].heapIndex;
+   }
+   void fetchBudgets();
+   [[nodiscard]] HeapBudget getHeapBudget(uint32_t heap_index) const;
+   [[nodiscard]] bool fitsInBudget(uint32_t heap_index, VkDeviceSize size);
+   void releaseEmptyBlocks(uint32_t heap_index);
+   [[nodiscard]] VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memory_type_index, void** mapped_data);
+   void freeDeviceMemory(VkDeviceMemory memory, VkDeviceSize size, uint32_t memory_type_index, bool mapped);
+   [[nodiscard]] Block* findBlock(uint32_t pool_index, VkDeviceMemory memory) const;
+   [[nodiscard]] static VkDeviceSize getUsedBytes(const Block& block);
+   static bool allocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+   static void freeToBlock(Block& block, VkDeviceSize offset, VkDeviceSize size);
+   Allocation allocateDedicated(VkDeviceSize size, uint32_t memory_type_index);
+};
\ No newline at end of file
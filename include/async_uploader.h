@@ -0,0 +1,82 @@
+#pragma once
+
+#include "upload_batch.h"
+
+// Streams buffer and image uploads from a background thread on the transfer queue, falling back to the graphics queue
+// when the device has no separate transfer family. Every upload returns a ticket, which is the timeline semaphore value
+// its batch signals; a resource may be used once acquire() has recorded its ticket into a graphics command buffer.
+class AsyncUploaderVK final
+{
+public:
+   explicit AsyncUploaderVK(VkDeviceSize staging_ring_size);
+   ~AsyncUploaderVK();
+
+   [[nodiscard]] uint64_t uploadBuffer(VkBuffer dst_buffer, std::vector<uint8_t> data);
+   [[nodiscard]] uint64_t uploadImage(
+      VkImage dst_image,
+      std::vector<uint8_t> data,
+      uint32_t width,
+      uint32_t height,
+      uint32_t mip_levels = 1,
+      std::vector<VkDeviceSize> level_offsets = { 0 }
+   );
+   [[nodiscard]] uint64_t acquire(VkCommandBuffer command_buffer);
+   [[nodiscard]] bool isReady(uint64_t ticket) const { return ticket <= AcquiredValue; }
+   [[nodiscard]] uint64_t getAcquiredValue() const { return AcquiredValue; }
+   [[nodiscard]] VkSemaphore getTimelineSemaphore() const { return TimelineSemaphore; }
+   [[nodiscard]] static VkPipelineStageFlags getAcquireStages()
+   {
+      return VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+   }
+
+private:
+   struct Request
+   {
+      VkBuffer Buffer;
+      VkImage Image;
+      std::vector<uint8_t> Data;
+      std::vector<VkDeviceSize> LevelOffsets;
+      uint32_t Width;
+      uint32_t Height;
+      uint32_t MipLevels;
+
+      Request() : Buffer( VK_NULL_HANDLE ), Image( VK_NULL_HANDLE ), Width( 0 ), Height( 0 ), MipLevels( 1 ) {}
+   };
+
+   struct Submission
+   {
+      std::unique_ptr<UploadBatchVK> Batch;
+      uint64_t Value;
+   };
+
+   struct PendingAcquire
+   {
+      std::vector<VkBufferMemoryBarrier> BufferBarriers;
+      std::vector<VkImageMemoryBarrier> ImageBarriers;
+      std::vector<UploadBatchVK::MipmapGeneration> MipmapGenerations;
+      uint64_t Value;
+   };
+
+   VkCommandPool CommandPool;
+   VkSemaphore TimelineSemaphore;
+   std::unique_ptr<StagingRingVK> StagingRing;
+   std::thread Worker;
+   std::mutex Mutex;
+   std::condition_variable Condition;
+   bool Stop;
+   std::vector<Request> Requests;
+   std::vector<PendingAcquire> PendingAcquires;
+   uint64_t NextValue;
+
+   // Only touched by the worker thread while it runs.
+   std::vector<Submission> InFlight;
+
+   // Only touched by the rendering thread.
+   uint64_t AcquiredValue;
+
+   [[nodiscard]] uint64_t enqueue(Request&& request);
+   void run();
+   void submit(std::vector<Request>& requests, uint64_t value);
+   void reclaim();
+};
\ No newline at end of file
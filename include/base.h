@@ -32,8 +32,14 @@
 #include <algorithm>
 #include <limits>
 #include <array>
+#include <bitset>
+#include <tuple>
+#include <utility>
 #include <vector>
+#include <deque>
 #include <string>
+#include <cstring>
+#include <cmath>
 #include <map>
 #include <unordered_map>
 #include <set>
@@ -44,7 +50,39 @@
 #include <filesystem>
 #include <memory>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <cassert>
+#include <random>
 
 #include "project_constants.h"
 
-using uint = unsigned int;
\ No newline at end of file
+using uint = unsigned int;
+
+// 64-bit FNV-1a. Passing the previous result as the hash mixes several pieces of data into one value.
+inline constexpr uint64_t FNVOffsetBasis = 0xcbf29ce484222325ull;
+
+inline uint64_t getFNVHash(const void* data, size_t size, uint64_t hash = FNVOffsetBasis)
+{
+   const auto* bytes = static_cast<const uint8_t*>(data);
+   for (size_t i = 0; i < size; ++i) {
+      hash ^= bytes[i];
+      hash *= 0x100000001b3ull;
+   }
+   return hash;
+}
+
+// A name next to file_path that no other thread or process writes at the same time, so that a file can be written in
+// full and then renamed over its destination.
+inline std::string getTemporaryPath(const std::string& file_path)
+{
+   static std::atomic<uint64_t> path_count{ 0 };
+   const uint64_t suffix = (static_cast<uint64_t>(std::random_device{}()) << 32) ^ path_count++;
+   std::ostringstream path_stream;
+   path_stream << file_path << "." << std::hex << suffix << ".tmp";
+   return path_stream.str();
+}
\ No newline at end of file
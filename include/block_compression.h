@@ -0,0 +1,101 @@
+#pragma once
+
+#include "base.h"
+
+// Host-side helpers for block-compressed formats. Decoding is only the fallback for devices that cannot sample a
+// format, so it favors simplicity over speed. Encoding runs at load time when a texture has no compressed version yet;
+// it fits endpoints to the bounding box of each block, which is fast and good enough for the usual color textures.
+class BlockCompressionVK final
+{
+public:
+   [[nodiscard]] static bool isBlockCompressed(VkFormat format);
+   [[nodiscard]] static bool isSRGB(VkFormat format);
+   [[nodiscard]] static uint32_t getBlockWidth(VkFormat format);
+   [[nodiscard]] static uint32_t getBlockHeight(VkFormat format);
+   [[nodiscard]] static uint32_t getBlockSize(VkFormat format);
+   [[nodiscard]] static VkDeviceSize getLevelSize(VkFormat format, uint32_t width, uint32_t height);
+   [[nodiscard]] static bool canDecode(VkFormat format);
+   [[nodiscard]] static bool canEncode(VkFormat format);
+
+   // Decodes one level into tightly packed RGBA8 texels.
+   static void decode(VkFormat format, const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* texels);
+
+   // Encodes one level of tightly packed RGBA8 texels on the calling thread.
+   static void encode(VkFormat format, const uint8_t* texels, uint32_t width, uint32_t height, uint8_t* blocks);
+
+private:
+   struct BC7Mode
+   {
+      uint32_t Subsets;
+      uint32_t PartitionBits;
+      uint32_t RotationBits;
+      uint32_t IndexSelectionBits;
+      uint32_t ColorBits;
+      uint32_t AlphaBits;
+      uint32_t EndpointPBits;
+      uint32_t SharedPBits;
+      uint32_t IndexBits;
+      uint32_t SecondaryIndexBits;
+   };
+
+   class BitReader final
+   {
+   public:
+      explicit BitReader(const uint8_t* data) : Data( data ), Position( 0 ) {}
+
+      uint32_t read(uint32_t count)
+      {
+         uint32_t value = 0;
+         for (uint32_t i = 0; i < count; ++i, ++Position) {
+            value |= static_cast<uint32_t>((Data[Position >> 3] >> (Position & 7)) & 1) << i;
+         }
+         return value;
+      }
+
+   private:
+      const uint8_t* Data;
+      uint32_t Position;
+   };
+
+   class BitWriter final
+   {
+   public:
+      explicit BitWriter(uint8_t* data) : Data( data ), Position( 0 ) {}
+
+      void write(uint32_t value, uint32_t count)
+      {
+         for (uint32_t i = 0; i < count; ++i, ++Position) {
+            if ((value >> i) & 1) Data[Position >> 3] |= static_cast<uint8_t>(1 << (Position & 7));
+         }
+      }
+
+   private:
+      uint8_t* Data;
+      uint32_t Position;
+   };
+
+   static const BC7Mode BC7Modes[8];
+   static const uint16_t BC7Partitions2[64];
+   static const uint8_t BC7Partitions3[64][16];
+   static const uint8_t BC7Anchors2[64];
+   static const uint8_t BC7Anchors3[2][64];
+
+   static void decodeBC1(const uint8_t* block, uint8_t* texels, bool three_color_mode, bool punch_through_alpha);
+   static void decodeBC3Alpha(const uint8_t* block, uint8_t* texels);
+   static void decodeBC7(const uint8_t* block, uint8_t* texels);
+   [[nodiscard]] static uint32_t getBC7Subset(uint32_t subsets, uint32_t partition, uint32_t texel);
+   [[nodiscard]] static bool isBC7Anchor(uint32_t subsets, uint32_t partition, uint32_t texel);
+   [[nodiscard]] static uint32_t interpolateBC7(uint32_t e0, uint32_t e1, uint32_t index, uint32_t index_bits);
+   static void loadBlock(
+      const uint8_t* texels,
+      uint32_t width,
+      uint32_t height,
+      uint32_t block_x,
+      uint32_t block_y,
+      uint8_t* block_texels
+   );
+   static void getBounds(const uint8_t* block_texels, uint8_t* min_texel, uint8_t* max_texel);
+   static void encodeBC1(const uint8_t* block_texels, uint8_t* block);
+   static void encodeBC3Alpha(const uint8_t* block_texels, uint8_t* block);
+   static void encodeBC7(const uint8_t* block_texels, uint8_t* block);
+};
\ No newline at end of file
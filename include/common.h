@@ -1,6 +1,8 @@
 #pragma once
 
-#include "base.h"
+#include "allocator.h"
+#include "descriptor_allocator.h"
+#include "pipeline_registry.h"
 
 class CommonVK final
 {
@@ -9,6 +11,7 @@ public:
    {
       std::optional<uint32_t> GraphicsFamily;
       std::optional<uint32_t> PresentFamily;
+      std::optional<uint32_t> TransferFamily;
 
       [[nodiscard]] bool isComplete() const { return GraphicsFamily.has_value() && PresentFamily.has_value(); }
    };
@@ -27,10 +30,22 @@ public:
    [[nodiscard]] static const char* const* getValidationLayerNames() { return ValidationLayers.data(); }
    [[nodiscard]] static int getMaxFramesInFlight() { return MaxFramesInFlight; }
    [[nodiscard]] static VkPhysicalDevice getPhysicalDevice() { return PhysicalDevice; }
+   [[nodiscard]] static const VkPhysicalDeviceProperties& getPhysicalDeviceProperties()
+   {
+      return PhysicalDeviceProperties;
+   }
+   [[nodiscard]] static bool hasUnifiedMemory() { return UnifiedMemory; }
+   [[nodiscard]] static bool hasMemoryBudget() { return MemoryBudgetSupported; }
    [[nodiscard]] static VkDevice getDevice() { return Device; }
    [[nodiscard]] static VkQueue getGraphicsQueue() { return GraphicsQueue; }
    [[nodiscard]] static VkQueue getPresentQueue() { return PresentQueue; }
+   [[nodiscard]] static VkQueue getTransferQueue() { return TransferQueue; }
+   [[nodiscard]] static uint32_t getGraphicsQueueFamily() { return GraphicsQueueFamily; }
+   [[nodiscard]] static uint32_t getTransferQueueFamily() { return TransferQueueFamily; }
+   [[nodiscard]] static bool hasDedicatedTransferQueue() { return TransferQueueFamily != GraphicsQueueFamily; }
    [[nodiscard]] static VkCommandPool getCommandPool() { return CommandPool; }
+   [[nodiscard]] static MemoryAllocatorVK* getAllocator() { return Allocator.get(); }
+   [[nodiscard]] static DescriptorAllocatorVK* getDescriptorAllocator() { return DescriptorAllocator.get(); }
    [[nodiscard]] static QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface);
    [[nodiscard]] static SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
    [[nodiscard]] static bool isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface);
@@ -38,35 +53,77 @@ public:
    {
       return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
    }
+   [[nodiscard]] static bool isFormatSupported(VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features);
    [[nodiscard]] static VkFormat findSupportedFormat(
       const std::vector<VkFormat>& candidates,
       VkImageTiling tiling,
       VkFormatFeatureFlags features
    );
    [[nodiscard]] static VkFormat findDepthFormat();
-   [[nodiscard]] static uint32_t findMemoryType(uint32_t type_filter, VkMemoryPropertyFlags properties);
+   [[nodiscard]] static uint32_t findMemoryType(uint32_t type_filter, MemoryAllocatorVK::Usage usage)
+   {
+      return Allocator->findMemoryType( type_filter, usage );
+   }
    static bool checkValidationLayerSupport();
    static void pickPhysicalDevice(VkInstance Instance, VkSurfaceKHR surface);
    static void createLogicalDevice(VkSurfaceKHR surface);
    static void createCommandPool(VkSurfaceKHR surface);
+   static void createAllocator();
+   static void destroyAllocator();
+   static void createDescriptorAllocator();
+   static void destroyDescriptorAllocator();
+   // The cache starts from the file when it was written by the same driver for the same device, and is written back to
+   // it on destruction. Every pipeline is created through it.
+   [[nodiscard]] static VkPipelineCache getPipelineCache() { return PipelineCache; }
+   [[nodiscard]] static bool isPipelineCacheWarm() { return PipelineCacheWarm; }
+   static void createPipelineCache(const std::string& file_path);
+   static void destroyPipelineCache();
+   [[nodiscard]] static PipelineRegistryVK* getPipelineRegistry() { return PipelineRegistry.get(); }
+   static void createPipelineRegistry();
+   static void destroyPipelineRegistry();
    static void createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
-      VkMemoryPropertyFlags properties,
+      MemoryAllocatorVK::Usage memory_usage,
       VkBuffer& buffer,
-      VkDeviceMemory& buffer_memory
+      MemoryAllocatorVK::Allocation& buffer_memory
    );
+   static void destroyBuffer(VkBuffer& buffer, MemoryAllocatorVK::Allocation& buffer_memory);
    static void createImage(
       uint32_t width,
       uint32_t height,
       VkFormat format,
       VkImageTiling tiling,
       VkImageUsageFlags usage,
-      VkMemoryPropertyFlags properties,
+      MemoryAllocatorVK::Usage memory_usage,
       VkImage& image,
-      VkDeviceMemory& image_memory
+      MemoryAllocatorVK::Allocation& image_memory,
+      uint32_t mip_levels = 1,
+      uint32_t array_layers = 1
    );
-   static VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect_flags);
+   static void destroyImage(VkImage& image, MemoryAllocatorVK::Allocation& image_memory);
+   static VkImageView createImageView(
+      VkImage image,
+      VkFormat format,
+      VkImageAspectFlags aspect_flags,
+      uint32_t mip_levels = 1,
+      uint32_t layer_count = 1,
+      const VkComponentMapping& components = {}
+   );
+   [[nodiscard]] static uint32_t getMipLevelCount(uint32_t width, uint32_t height);
+   [[nodiscard]] static bool supportsLinearBlit(VkFormat format);
+   static void generateMipmaps(
+      VkCommandBuffer command_buffer,
+      VkImage image,
+      uint32_t width,
+      uint32_t height,
+      uint32_t mip_levels
+   );
+   [[nodiscard]] static VkSampler getSampler(const VkSamplerCreateInfo& sampler_info);
+   static void destroySamplers();
+   static VkResult submitToQueue(VkQueue queue, const VkSubmitInfo& submit_info, VkFence fence);
+   static VkResult presentToQueue(const VkPresentInfoKHR& present_info);
+   static void waitDeviceIdle();
    static VkCommandBuffer createCommandBuffer(VkCommandBufferLevel level);
    static void flushCommandBuffer(VkCommandBuffer commandBuffer);
    static void insertImageMemoryBarrier(
@@ -82,6 +139,29 @@ public:
    );
 
 private:
+   // Precedes the driver's cache data in the file. The data has its own header with the vendor, the device and the
+   // cache UUID, but nothing that catches a truncated or corrupted file, or a driver update that keeps the UUID.
+   struct PipelineCacheFileHeader
+   {
+      uint32_t Magic;
+      uint32_t DriverVersion;
+      uint64_t DataSize;
+      uint64_t Checksum;
+   };
+
+   inline static constexpr uint32_t PipelineCacheMagic = 0x4350564b;
+
+   // Every state member of VkSamplerCreateInfo, with floats stored by their bit patterns.
+   using SamplerKey = std::array<uint32_t, 16>;
+
+   struct SamplerKeyHash
+   {
+      size_t operator()(const SamplerKey& key) const
+      {
+         return static_cast<size_t>(getFNVHash( key.data(), sizeof( key ) ));
+      }
+   };
+
    inline static const std::array<const char*, 1> ValidationLayers = {
       "VK_LAYER_KHRONOS_validation"
    };
@@ -90,10 +170,31 @@ private:
    };
    inline static int MaxFramesInFlight = 2;
    inline static VkPhysicalDevice PhysicalDevice = VK_NULL_HANDLE;
+   inline static VkPhysicalDeviceProperties PhysicalDeviceProperties{};
+   inline static bool UnifiedMemory = false;
+   inline static bool MemoryBudgetSupported = false;
    inline static VkDevice Device{};
    inline static VkQueue GraphicsQueue{};
    inline static VkQueue PresentQueue{};
+   inline static VkQueue TransferQueue{};
+   inline static uint32_t GraphicsQueueFamily = 0;
+   inline static uint32_t TransferQueueFamily = 0;
+
+   // The uploader thread may fall back to the graphics queue, so every queue submission goes through this lock.
+   inline static std::mutex QueueMutex;
    inline static VkCommandPool CommandPool{};
+   inline static std::unique_ptr<MemoryAllocatorVK> Allocator;
+   inline static std::unique_ptr<DescriptorAllocatorVK> DescriptorAllocator;
+   inline static VkPipelineCache PipelineCache{};
+   inline static bool PipelineCacheWarm = false;
+   inline static std::string PipelineCacheFilePath;
+   inline static std::unique_ptr<PipelineRegistryVK> PipelineRegistry;
+   inline static std::unordered_map<SamplerKey, VkSampler, SamplerKeyHash> Samplers;
+   inline static std::mutex SamplerMutex;
 
    static bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+   [[nodiscard]] static bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extension_name);
+   [[nodiscard]] static bool checkUnifiedMemory(VkPhysicalDevice device);
+   [[nodiscard]] static std::vector<uint8_t> readPipelineCacheFile(const std::string& file_path);
+   static void writePipelineCacheFile(const std::string& file_path);
 };
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "common.h"
+
+// Moves registered device-local buffers and images out of sparsely used memory blocks into fuller ones, a few per step,
+// so that emptied blocks go back to the device. The copies of a step are recorded into a frame's command buffer. Once
+// that frame has been submitted, completeMoves() switches the owners' handles over, since later submissions to the
+// queue are ordered after the copies, and calls their callbacks so that views and descriptor sets are replaced. The old
+// resources are handed to the caller's deferred destruction, because frames still in flight may be using them.
+class DefragmenterVK final
+{
+public:
+   // Takes a destruction that has to wait until no frame submitted so far is running anymore.
+   using DeferDestruction = std::function<void(std::function<void()>)>;
+   using MovedCallback = std::function<void(const DeferDestruction&)>;
+
+   DefragmenterVK(VkDeviceSize max_bytes_per_step, uint32_t max_moves_per_step);
+   ~DefragmenterVK();
+
+   DefragmenterVK(const DefragmenterVK&) = delete;
+   DefragmenterVK& operator=(const DefragmenterVK&) = delete;
+
+   // The handle and allocation are written in place when the resource moves, so they have to stay at the same address
+   // until it is unregistered. A resource is only moved once its upload ticket has been acquired. Buffers need
+   // TRANSFER_SRC usage, and images also have to be kept in SHADER_READ_ONLY_OPTIMAL.
+   [[nodiscard]] uint64_t registerBuffer(
+      VkBuffer& buffer,
+      MemoryAllocatorVK::Allocation& memory,
+      VkDeviceSize size,
+      VkBufferUsageFlags usage,
+      uint64_t upload_ticket,
+      MovedCallback on_moved = {}
+   );
+   [[nodiscard]] uint64_t registerImage(
+      VkImage& image,
+      MemoryAllocatorVK::Allocation& memory,
+      uint32_t width,
+      uint32_t height,
+      VkFormat format,
+      VkImageUsageFlags usage,
+      uint32_t mip_levels,
+      uint64_t upload_ticket,
+      MovedCallback on_moved = {}
+   );
+   void unregister(uint64_t id);
+
+   [[nodiscard]] VkDeviceSize getBytesReclaimed() const;
+
+   // Records the copies for the resources in the sparsest blocks into a graphics command buffer, and returns how many.
+   uint32_t recordMoves(VkCommandBuffer command_buffer, uint64_t acquired_upload_value);
+
+   // Has to be called after the command buffer of the last recordMoves() has been submitted, on the same queue as the
+   // frames that use the resources. The deferred destructions refer to this defragmenter, so they have to run before it
+   // is destroyed. Returns how many resources now live somewhere else.
+   uint32_t completeMoves(const DeferDestruction& defer_destruction);
+
+private:
+   struct Resource
+   {
+      VkBuffer* Buffer;
+      VkImage* Image;
+      MemoryAllocatorVK::Allocation* Memory;
+      VkDeviceSize BufferSize;
+      VkBufferUsageFlags BufferUsage;
+      uint32_t Width;
+      uint32_t Height;
+      VkFormat Format;
+      VkImageUsageFlags ImageUsage;
+      uint32_t MipLevels;
+      uint64_t UploadTicket;
+      MovedCallback OnMoved;
+
+      Resource() :
+         Buffer( nullptr ), Image( nullptr ), Memory( nullptr ), BufferSize( 0 ), BufferUsage( 0 ), Width( 0 ),
+         Height( 0 ), Format( VK_FORMAT_UNDEFINED ), ImageUsage( 0 ), MipLevels( 1 ), UploadTicket( 0 ) {}
+   };
+
+   struct Move
+   {
+      uint64_t ResourceId;
+      VkBuffer Buffer;
+      VkImage Image;
+      MemoryAllocatorVK::Allocation Memory;
+   };
+
+   // Blocks that are fuller than this are not worth emptying.
+   inline static constexpr float MaxSourceOccupancy = 0.5f;
+
+   VkDeviceSize MaxBytesPerStep;
+   uint32_t MaxMovesPerStep;
+   VkDeviceSize BytesReclaimed;
+   uint64_t NextId;
+
+   // Textures register from the thread pool, so the registry is locked.
+   mutable std::mutex Mutex;
+   std::unordered_map<uint64_t, Resource> Resources;
+   std::vector<Move> PendingMoves;
+
+   [[nodiscard]] static bool createBuffer(const Resource& resource, Move& move);
+   [[nodiscard]] static bool createImage(const Resource& resource, Move& move);
+   static void recordBufferCopy(VkCommandBuffer command_buffer, const Resource& resource, const Move& move);
+   static void recordImageCopy(VkCommandBuffer command_buffer, const Resource& resource, const Move& move);
+   static void destroy(Move& move);
+   void release(Move& move);
+};
\ No newline at end of file
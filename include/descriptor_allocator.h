@@ -0,0 +1,69 @@
+#pragma once
+
+#include "base.h"
+
+// Hands out descriptor sets from lists of large pools, and creates a bigger pool whenever the existing ones run out.
+// Persistent sets stay valid until they are freed. Transient sets belong to a frame slot and are all recycled at once
+// by resetFrame() when that slot comes around again, so they never have to be freed one by one.
+class DescriptorAllocatorVK final
+{
+public:
+   DescriptorAllocatorVK(VkDevice device, uint32_t frame_count);
+   ~DescriptorAllocatorVK();
+
+   DescriptorAllocatorVK(const DescriptorAllocatorVK&) = delete;
+   DescriptorAllocatorVK& operator=(const DescriptorAllocatorVK&) = delete;
+
+   [[nodiscard]] VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+   // Called from destructors, so a set this allocator does not know is only caught by the assertion in debug builds.
+   void free(VkDescriptorSet descriptor_set) noexcept;
+
+   // Only valid until resetFrame() is called with the same frame index, which has to wait for that frame's fence.
+   [[nodiscard]] VkDescriptorSet allocateTransient(uint32_t frame_index, VkDescriptorSetLayout layout);
+   void resetFrame(uint32_t frame_index);
+
+   [[nodiscard]] size_t getPoolCount() const;
+
+private:
+   struct PoolList
+   {
+      std::vector<VkDescriptorPool> Pools;
+      size_t CurrentPool;
+      uint32_t NextPoolSetCount;
+
+      PoolList() : CurrentPool( 0 ), NextPoolSetCount( InitialPoolSetCount ) {}
+   };
+
+   // Descriptors of each type reserved per set in a pool; a set that holds more of a type than this just leaves a pool
+   // full earlier.
+   struct PoolSizeRatio
+   {
+      VkDescriptorType Type;
+      float Ratio;
+   };
+
+   inline static constexpr uint32_t InitialPoolSetCount = 64;
+   inline static constexpr uint32_t MaxPoolSetCount = 4096;
+   inline static constexpr std::array<PoolSizeRatio, 4> PoolSizeRatios = { {
+      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+      { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f },
+      { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0.5f }
+   } };
+
+   VkDevice Device;
+   mutable std::mutex Mutex;
+   PoolList Persistent;
+   std::unordered_map<VkDescriptorSet, VkDescriptorPool> PersistentOwners;
+   std::vector<PoolList> Transient;
+
+   [[nodiscard]] VkDescriptorPool createPool(PoolList& list, VkDescriptorPoolCreateFlags flags);
+   [[nodiscard]] VkResult allocateFromPool(VkDescriptorPool pool, VkDescriptorSetLayout layout, VkDescriptorSet& set);
+   [[nodiscard]] VkDescriptorSet allocateFromList(
+      PoolList& list,
+      VkDescriptorSetLayout layout,
+      VkDescriptorPoolCreateFlags flags,
+      VkDescriptorPool& pool
+   );
+};
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "texture.h"
+
+// Reads 2D textures with pre-built mip levels from KTX2 containers. Block-compressed levels are uploaded as they are
+// when the device can sample the format, and decoded to RGBA8 otherwise.
+class KTX2ReaderVK final
+{
+public:
+   explicit KTX2ReaderVK(const std::string& file_path);
+   ~KTX2ReaderVK() = default;
+
+   inline static constexpr std::array<uint8_t, 12> Identifier = {
+      0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+   };
+   inline static constexpr size_t HeaderSize = 80;
+   inline static constexpr size_t LevelIndexEntrySize = 24;
+
+   [[nodiscard]] static bool isKTX2File(const std::string& file_path);
+   [[nodiscard]] TextureVK::ImageData getImageData() const;
+
+private:
+   struct Level
+   {
+      uint64_t ByteOffset;
+      uint64_t ByteLength;
+   };
+
+   std::vector<uint8_t> FileData;
+   VkFormat Format;
+   uint32_t Width;
+   uint32_t Height;
+   std::vector<Level> Levels;
+
+   [[nodiscard]] uint32_t readUint32(size_t offset) const;
+   [[nodiscard]] uint64_t readUint64(size_t offset) const;
+   [[nodiscard]] static bool isSupportedFormat(VkFormat format);
+};
\ No newline at end of file
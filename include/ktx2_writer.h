@@ -0,0 +1,16 @@
+#pragma once
+
+#include "ktx2_reader.h"
+
+// Writes a texture with all of its levels into a KTX2 container without supercompression. The file is written next to
+// its destination first and then renamed over it, so a reader never sees a partially written file.
+class KTX2WriterVK final
+{
+public:
+   static void write(const std::string& file_path, const TextureVK::ImageData& image_data);
+
+private:
+   [[nodiscard]] static std::vector<uint32_t> getDataFormatDescriptor(VkFormat format);
+   static void writeUint32(std::vector<uint8_t>& file_data, size_t offset, uint32_t value);
+   static void writeUint64(std::vector<uint8_t>& file_data, size_t offset, uint64_t value);
+};
\ No newline at end of file
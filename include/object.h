@@ -1,6 +1,7 @@
 #pragma once
 
-#include "common.h"
+#include "uniform_ring_buffer.h"
+#include "texture_cache.h"
 
 class ObjectVK final
 {
@@ -8,20 +9,32 @@ public:
    explicit ObjectVK(CommonVK* common);
    ~ObjectVK();
 
-   void setSquareObject(const std::string& texture_file_path);
+   void setSquareObject(const std::string& texture_file_path, TextureCacheVK& texture_cache);
    static VkVertexInputBindingDescription getBindingDescription();
    static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions();
-   void createDescriptorPool();
-   void createUniformBuffers();
-   void createDescriptorSets(VkDescriptorSetLayout descriptor_set_layout);
-   void updateUniformBuffer(uint32_t current_image, VkExtent2D extent, const glm::mat4& to_world);
+   [[nodiscard]] static VkDeviceSize getObjectUniformBufferSize() { return sizeof( ObjectUniformBufferObject ); }
+   void setMaterial(
+      const glm::vec4& emission_color,
+      const glm::vec4& ambient_color,
+      const glm::vec4& diffuse_color,
+      const glm::vec4& specular_color,
+      float specular_exponent
+   );
+   void createMaterialDescriptorSets(VkDescriptorSetLayout descriptor_set_layout);
+   // Has to be called once the frame's fence has signaled, since it also rewrites the frame's stale descriptors.
+   void updateUniformBuffer(UniformRingBufferVK& uniform_ring, uint32_t frame_index, const glm::mat4& to_world);
    [[nodiscard]] const void* getVertexData() const { return Vertices.data(); }
    [[nodiscard]] uint32_t getVertexSize() const { return static_cast<uint32_t>(Vertices.size()); }
    [[nodiscard]] VkDeviceSize getVertexBufferSize() const { return sizeof( Vertices[0] ) * Vertices.size(); };
-   [[nodiscard]] VkImageView getTextureImageView() const { return TextureImageView; }
+   [[nodiscard]] VkImageView getTextureImageView() const { return Texture->getImageView(); }
    [[nodiscard]] VkSampler getTextureSampler() const { return TextureSampler; }
-   [[nodiscard]] VkDescriptorPool getDescriptorPool() const { return DescriptorPool; }
-   [[nodiscard]] const VkDescriptorSet* getDescriptorSet(uint32_t index) const { return &DescriptorSets[index]; }
+   [[nodiscard]] VkDescriptorSet getMaterialDescriptorSet(uint32_t frame_index) const
+   {
+      return MaterialDescriptorSets[frame_index];
+   }
+   [[nodiscard]] uint64_t getUploadTicket() const { return Texture->getUploadTicket(); }
+   [[nodiscard]] uint32_t getDynamicOffsetSize() const { return static_cast<uint32_t>(DynamicOffsets.size()); }
+   [[nodiscard]] const uint32_t* getDynamicOffsets() const { return DynamicOffsets.data(); }
 
 private:
    struct Vertex
@@ -34,17 +47,9 @@ private:
          Position( position ), Normal( normal ), Texture( texture ) {}
    };
 
-   struct UniformBuffer
-   {
-      std::vector<VkBuffer> UniformBuffers;
-      std::vector<VkDeviceMemory> UniformBuffersMemory;
-   };
-
-   struct MVPUniformBufferObject
+   struct ObjectUniformBufferObject
    {
-       alignas(16) glm::mat4 Model;
-       alignas(16) glm::mat4 View;
-       alignas(16) glm::mat4 Projection;
+      alignas(16) glm::mat4 Model;
    };
 
    struct MaterialUniformBufferObject
@@ -56,37 +61,30 @@ private:
       alignas(16) float SpecularExponent;
    };
 
-   struct LightUniformBufferObject
-   {
-      alignas(16) glm::vec4 Position;
-      alignas(16) glm::vec4 AmbientColor;
-      alignas(16) glm::vec4 DiffuseColor;
-      alignas(16) glm::vec4 SpecularColor;
-      alignas(16) glm::vec3 AttenuationFactors;
-      alignas(16) glm::vec3 SpotlightDirection;
-      alignas(16) float SpotlightCutoffAngle;
-      alignas(16) float SpotlightFeather;
-      alignas(16) float FallOffRadius;
-   };
-
    CommonVK* Common;
    std::vector<Vertex> Vertices;
-   VkImage TextureImage;
-   VkDeviceMemory TextureImageMemory;
-   VkImageView TextureImageView;
+   TextureCacheVK::TextureFuture PendingTexture;
+   std::shared_ptr<TextureVK> Texture;
    VkSampler TextureSampler;
-   VkDescriptorPool DescriptorPool;
-   UniformBuffer MVP;
-   UniformBuffer Material;
-   UniformBuffer Light;
-   std::vector<VkDescriptorSet> DescriptorSets;
+   MaterialUniformBufferObject Material;
+   VkBuffer MaterialBuffer;
+   MemoryAllocatorVK::Allocation MaterialBufferMemory;
+   VkDeviceSize MaterialStride;
+   std::vector<VkDescriptorSet> MaterialDescriptorSets;
+   uint64_t TextureSubscription;
+
+   // The material buffer holds one copy per frame in flight, so a change is written to each copy once that frame comes
+   // around again instead of overwriting data the GPU may still be reading. Bit i is set while copy i is stale.
+   uint32_t MaterialDirtyFrames;
+
+   // The same goes for the material descriptor sets, whose texture view is replaced when the texture moves.
+   uint32_t TextureDirtyFrames;
+
+   // Offsets of this frame's material copy and model matrix in set order, material set first.
+   std::array<uint32_t, 2> DynamicOffsets;
 
    static void getSquareObject(std::vector<Vertex>& vertices);
-   [[nodiscard]] static VkCommandBuffer beginSingleTimeCommands();
-   static void endSingleTimeCommands(VkCommandBuffer command_buffer);
-   static void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout);
-   static void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
-   void createTextureImage(const std::string& texture_file_path);
-   void createTextureImageView();
    void createTextureSampler();
+   void createMaterialBuffer();
+   void updateTextureDescriptor(uint32_t frame_index);
 };
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "base.h"
+
+// Owns every shader module, render pass, descriptor set layout, pipeline layout and graphics pipeline, and hands out
+// the existing object whenever a request describes one that was already created. Keys hold every field that goes into
+// the create info, so two materials share a pipeline exactly when Vulkan could not tell their pipelines apart. Objects
+// live until the registry is destroyed.
+class PipelineRegistryVK final
+{
+public:
+   // Everything a graphics pipeline is built from. The viewport and scissor are always dynamic state.
+   struct GraphicsPipelineDescription
+   {
+      VkShaderModule VertexShader;
+      VkShaderModule FragmentShader;
+      std::vector<VkVertexInputBindingDescription> VertexBindings;
+      std::vector<VkVertexInputAttributeDescription> VertexAttributes;
+      VkPrimitiveTopology Topology;
+      VkPolygonMode PolygonMode;
+      VkCullModeFlags CullMode;
+      VkFrontFace FrontFace;
+      VkBool32 DepthTestEnable;
+      VkBool32 DepthWriteEnable;
+      VkCompareOp DepthCompareOp;
+      VkPipelineColorBlendAttachmentState ColorBlendAttachment;
+      VkPipelineLayout Layout;
+      VkRenderPass RenderPass;
+      uint32_t Subpass;
+
+      GraphicsPipelineDescription() :
+         VertexShader( VK_NULL_HANDLE ), FragmentShader( VK_NULL_HANDLE ),
+         Topology( VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST ), PolygonMode( VK_POLYGON_MODE_FILL ),
+         CullMode( VK_CULL_MODE_NONE ), FrontFace( VK_FRONT_FACE_COUNTER_CLOCKWISE ), DepthTestEnable( VK_TRUE ),
+         DepthWriteEnable( VK_TRUE ), DepthCompareOp( VK_COMPARE_OP_LESS ), ColorBlendAttachment{},
+         Layout( VK_NULL_HANDLE ), RenderPass( VK_NULL_HANDLE ), Subpass( 0 )
+      {
+         ColorBlendAttachment.colorWriteMask =
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+      }
+   };
+
+   PipelineRegistryVK(VkDevice device, VkPipelineCache pipeline_cache);
+   ~PipelineRegistryVK();
+
+   PipelineRegistryVK(const PipelineRegistryVK&) = delete;
+   PipelineRegistryVK& operator=(const PipelineRegistryVK&) = delete;
+
+   // Keyed by the SPIR-V itself, so the same code loaded from different files still ends up in one pipeline.
+   [[nodiscard]] VkShaderModule getShaderModule(const std::vector<char>& code);
+
+   // A color and a depth attachment that are cleared and, for color, presented. The formats are all that decides which
+   // render passes are compatible here.
+   [[nodiscard]] VkRenderPass getRenderPass(VkFormat color_format, VkFormat depth_format);
+   [[nodiscard]] VkDescriptorSetLayout getDescriptorSetLayout(
+      const std::vector<VkDescriptorSetLayoutBinding>& bindings
+   );
+   [[nodiscard]] VkPipelineLayout getPipelineLayout(
+      const std::vector<VkDescriptorSetLayout>& set_layouts,
+      const std::vector<VkPushConstantRange>& push_constant_ranges = {}
+   );
+   [[nodiscard]] VkPipeline getGraphicsPipeline(const GraphicsPipelineDescription& description);
+   void printStatistics(std::ostream& stream) const;
+
+private:
+   using Key = std::vector<uint32_t>;
+
+   struct KeyHash
+   {
+      size_t operator()(const Key& key) const
+      {
+         return static_cast<size_t>(getFNVHash( key.data(), key.size() * sizeof( uint32_t ) ));
+      }
+   };
+
+   template<typename T>
+   static void appendHandle(Key& key, T handle)
+   {
+      uint64_t value = 0;
+      std::memcpy( &value, &handle, sizeof( handle ) );
+      key.emplace_back( static_cast<uint32_t>(value) );
+      key.emplace_back( static_cast<uint32_t>(value >> 32) );
+   }
+
+   VkDevice Device;
+   VkPipelineCache PipelineCache;
+   mutable std::mutex Mutex;
+   std::unordered_map<Key, VkShaderModule, KeyHash> ShaderModules;
+   std::unordered_map<Key, VkRenderPass, KeyHash> RenderPasses;
+   std::unordered_map<Key, VkDescriptorSetLayout, KeyHash> DescriptorSetLayouts;
+   std::unordered_map<Key, VkPipelineLayout, KeyHash> PipelineLayouts;
+   std::unordered_map<Key, VkPipeline, KeyHash> GraphicsPipelines;
+   uint64_t GraphicsPipelineRequests;
+
+   [[nodiscard]] VkPipeline createGraphicsPipeline(const GraphicsPipelineDescription& description) const;
+};
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "base.h"
+
+// Converts decoded 8-bit pixels into the tightly packed RGBA8 texels that textures are uploaded with, so that shaders
+// can sample them without swizzling. The SIMD path is picked at compile time: AVX2 or SSSE3 when the build enables
+// them, SSE2 on any x86-64 target and NEON on ARM, with a scalar loop for the remaining texels of a row. Every
+// conversion has an SSE2 path, so a baseline x86-64 build is never left with only the scalar loop.
+class PixelConversionVK final
+{
+public:
+   enum class Layout { RGB, BGR, RGBA, BGRA };
+
+   // Rows of the source are src_pitch bytes apart. Three-channel pixels get an opaque alpha; with premultiply_alpha,
+   // the color channels are scaled by alpha as they are written.
+   static void convertToRGBA(
+      Layout layout,
+      const uint8_t* src,
+      size_t src_pitch,
+      uint32_t width,
+      uint32_t height,
+      bool premultiply_alpha,
+      uint8_t* dst
+   );
+
+   // Rounded lookups from 8-bit sRGB values to 16-bit linear ones, and from 16-bit linear values back to 8-bit sRGB.
+   [[nodiscard]] static const std::array<uint16_t, 256>& getSRGBDecodeTable();
+   [[nodiscard]] static const std::vector<uint8_t>& getSRGBEncodeTable();
+
+   // Replaces 16-bit sRGB values with 16-bit linear ones in place, for formats that have no sRGB variant.
+   static void decodeSRGB16(uint16_t* values, size_t count);
+
+private:
+   [[nodiscard]] static float decodeSRGB(float value);
+   [[nodiscard]] static float encodeSRGB(float value);
+
+   static void swapRedBlue(const uint8_t* src, uint32_t width, uint8_t* dst);
+   static void expandToRGBA(const uint8_t* src, uint32_t width, bool swap_red_blue, uint8_t* dst);
+   static void premultiplyAlpha(uint8_t* texels, uint32_t width);
+};
\ No newline at end of file
@@ -12,6 +12,25 @@ public:
    void play();
 
 private:
+   struct SceneUniformBufferObject
+   {
+      alignas(16) glm::mat4 View;
+      alignas(16) glm::mat4 Projection;
+   };
+
+   struct LightUniformBufferObject
+   {
+      alignas(16) glm::vec4 Position;
+      alignas(16) glm::vec4 AmbientColor;
+      alignas(16) glm::vec4 DiffuseColor;
+      alignas(16) glm::vec4 SpecularColor;
+      alignas(16) glm::vec3 AttenuationFactors;
+      alignas(16) glm::vec3 SpotlightDirection;
+      alignas(16) float SpotlightCutoffAngle;
+      alignas(16) float SpotlightFeather;
+      alignas(16) float FallOffRadius;
+   };
+
    uint32_t FrameWidth;
    uint32_t FrameHeight;
    std::shared_ptr<CommonVK> Common;
@@ -25,20 +44,40 @@ private:
    std::vector<VkImageView> SwapChainImageViews;
    std::vector<VkFramebuffer> SwapChainFramebuffers;
    VkImage DepthImage;
-   VkDeviceMemory DepthImageMemory;
+   MemoryAllocatorVK::Allocation DepthImageMemory;
    VkImageView DepthImageView;
    VkBuffer VertexBuffer;
-   VkDeviceMemory VertexBufferMemory;
+   MemoryAllocatorVK::Allocation VertexBufferMemory;
+   uint64_t VertexBufferUploadTicket;
+   uint64_t VertexBufferDefragmentationId;
+   std::vector<VkBuffer> SceneUniformBuffers;
+   std::vector<MemoryAllocatorVK::Allocation> SceneUniformBuffersMemory;
+   VkDeviceSize LightUniformOffset;
+   // Transient sets of the frame being recorded; they live until the descriptor pools of that frame are reset.
+   VkDescriptorSet SceneDescriptorSet;
+   VkDescriptorSet ObjectDescriptorSet;
    std::vector<VkCommandBuffer> CommandBuffers;
    std::vector<VkSemaphore> ImageAvailableSemaphores;
    std::vector<VkSemaphore> RenderFinishedSemaphores;
    std::vector<VkFence> InFlightFences;
    uint32_t CurrentFrame;
+   uint64_t SubmittedFrames;
    bool FramebufferResized;
+   // Destruction callbacks tagged with SubmittedFrames at the time the resources were retired.
+   std::deque<std::pair<uint64_t, std::function<void()>>> DeletionQueue;
+   std::shared_ptr<UniformRingBufferVK> UniformRing;
+   std::unique_ptr<AsyncUploaderVK> Uploader;
+   std::unique_ptr<ThreadPoolVK> ThreadPool;
+   std::unique_ptr<DefragmenterVK> Defragmenter;
+   uint32_t FramesSinceDefragmentation;
+   std::unique_ptr<TextureCacheVK> TextureCache;
    std::shared_ptr<ObjectVK> UpperSquareObject;
    std::shared_ptr<ObjectVK> LowerSquareObject;
    std::shared_ptr<ShaderVK> Shader;
 
+   inline static constexpr std::chrono::seconds MemoryReportInterval{ 10 };
+   inline static constexpr uint32_t DefragmentationInterval = 60;
+
 #ifdef NDEBUG
    inline static constexpr bool EnableValidationLayers = false;
 #else
@@ -92,6 +131,9 @@ private:
    }
 
    void cleanupSwapChain();
+   void retireSwapChain();
+   void deferDestruction(std::function<void()> destroy);
+   void flushDeletionQueue(bool wait_for_frames);
    void initializeWindow();
    void createSurface();
    [[nodiscard]] static VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& available_formats);
@@ -99,17 +141,20 @@ private:
    [[nodiscard]] VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
    void createSwapChain();
    void createImageViews();
+   void createUniformRingBuffer();
+   void createSceneUniformBuffers();
+   void allocateFrameDescriptorSets();
    void createObject();
    void createGraphicsPipeline();
    void createDepthResources();
    void createFramebuffers();
-   static void copyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size);
    void createVertexBuffer();
    void createCommandBuffer();
    void createSyncObjects();
    void initializeVulkan();
-   void recordCommandBuffer(VkCommandBuffer command_buffer, uint32_t image_index);
+   [[nodiscard]] uint64_t recordCommandBuffer(VkCommandBuffer command_buffer, uint32_t image_index);
    void recreateSwapChain();
+   void updateSceneUniformBuffer();
    void drawFrame();
    void writeFrame();
    [[nodiscard]] static std::vector<const char*> getRequiredExtensions();
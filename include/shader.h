@@ -5,30 +5,34 @@
 class ShaderVK
 {
 public:
+   // Everything is looked up in the pipeline registry, which owns it, so shaders that describe the same pipeline share
+   // one and destroying a shader frees nothing.
    explicit ShaderVK(CommonVK* common);
-   virtual ~ShaderVK();
+   virtual ~ShaderVK() = default;
 
    [[nodiscard]] VkRenderPass getRenderPass() const { return RenderPass; }
-   [[nodiscard]] VkDescriptorSetLayout getDescriptorSetLayout() const { return DescriptorSetLayout; }
+   [[nodiscard]] VkDescriptorSetLayout getSceneDescriptorSetLayout() const { return SceneDescriptorSetLayout; }
+   [[nodiscard]] VkDescriptorSetLayout getMaterialDescriptorSetLayout() const { return MaterialDescriptorSetLayout; }
+   [[nodiscard]] VkDescriptorSetLayout getObjectDescriptorSetLayout() const { return ObjectDescriptorSetLayout; }
    [[nodiscard]] VkPipelineLayout getPipelineLayout() const { return PipelineLayout; }
    [[nodiscard]] VkPipeline getGraphicsPipeline() const { return GraphicsPipeline; }
    void createRenderPass(VkFormat color_format);
-   void createDescriptorSetLayout();
+   void createDescriptorSetLayouts();
    virtual void createGraphicsPipeline(
       const std::string& vertex_shader_path,
       const std::string& fragment_shader_path,
       const VkVertexInputBindingDescription& binding_description,
-      const  std::array<VkVertexInputAttributeDescription, 3>& attribute_descriptions,
-      const VkExtent2D& extent
+      const  std::array<VkVertexInputAttributeDescription, 3>& attribute_descriptions
    );
 
 private:
    CommonVK* Common;
    VkRenderPass RenderPass;
-   VkDescriptorSetLayout DescriptorSetLayout;
+   VkDescriptorSetLayout SceneDescriptorSetLayout;
+   VkDescriptorSetLayout MaterialDescriptorSetLayout;
+   VkDescriptorSetLayout ObjectDescriptorSetLayout;
    VkPipelineLayout PipelineLayout;
    VkPipeline GraphicsPipeline;
 
    static std::vector<char> readFile(const std::string& filename);
-   static VkShaderModule createShaderModule(const std::vector<char>& code);
 };
\ No newline at end of file
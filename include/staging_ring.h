@@ -0,0 +1,47 @@
+#pragma once
+
+#include "common.h"
+
+// One persistently mapped staging buffer that all uploads are written into back to back. Each submission commits the
+// space it used together with the timeline value it signals, and that space is handed back once the value is reached.
+class StagingRingVK final
+{
+public:
+   struct Region
+   {
+      VkBuffer Buffer;
+      VkDeviceSize Offset;
+      void* MappedData;
+
+      Region() : Buffer( VK_NULL_HANDLE ), Offset( 0 ), MappedData( nullptr ) {}
+   };
+
+   StagingRingVK(VkDeviceSize size, VkSemaphore timeline_semaphore);
+   ~StagingRingVK();
+
+   [[nodiscard]] VkDeviceSize getSize() const { return Size; }
+   [[nodiscard]] bool allocate(VkDeviceSize size, Region& region);
+   void commit(uint64_t timeline_value);
+   void reclaim();
+
+private:
+   struct Submission
+   {
+      uint64_t TimelineValue;
+      VkDeviceSize End;
+   };
+
+   VkDeviceSize Size;
+   VkDeviceSize Alignment;
+   VkDeviceSize Head;
+   VkDeviceSize Tail;
+   bool HasUncommittedData;
+   VkSemaphore TimelineSemaphore;
+   VkBuffer Buffer;
+   MemoryAllocatorVK::Allocation BufferMemory;
+   std::deque<Submission> Submissions;
+
+   [[nodiscard]] bool isEmpty() const { return Submissions.empty() && !HasUncommittedData; }
+   [[nodiscard]] bool tryAllocate(VkDeviceSize size, VkDeviceSize& offset);
+   [[nodiscard]] bool waitForOldestSubmission();
+};
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "async_uploader.h"
+#include "block_compression.h"
+#include "defragmenter.h"
+#include "pixel_conversion.h"
+
+// A sampled 2D image with its view. Textures are shared through TextureCacheVK, so they are only held by shared_ptr.
+class TextureVK final
+{
+public:
+   // Texels of every given mip level, packed back to back starting with level 0. An uncompressed image that comes with
+   // a single level gets the rest of its mip chain generated.
+   struct ImageData
+   {
+      VkFormat Format;
+      uint32_t Width;
+      uint32_t Height;
+      std::vector<uint8_t> Texels;
+      std::vector<VkDeviceSize> LevelOffsets;
+      VkComponentMapping Components;
+
+      ImageData() : Format( VK_FORMAT_UNDEFINED ), Width( 0 ), Height( 0 ), LevelOffsets{ 0 }, Components{} {}
+   };
+
+   // With a defragmenter, the image may move to other memory, which gives it a new view: every user of the texture has
+   // to subscribe and rewrite its descriptor sets with getImageView() when notified.
+   TextureVK(ImageData image_data, AsyncUploaderVK& uploader, DefragmenterVK* defragmenter = nullptr);
+   ~TextureVK();
+
+   // Appends the rest of the mip chain to an RGBA8 image that holds a single level. The color of sRGB images is
+   // averaged in linear space, the same way a blit filters it.
+   static void generateMipChain(ImageData& image_data);
+
+   TextureVK(const TextureVK&) = delete;
+   TextureVK& operator=(const TextureVK&) = delete;
+
+   [[nodiscard]] VkImage getImage() const { return Image; }
+   [[nodiscard]] VkImageView getImageView() const { return ImageView; }
+   [[nodiscard]] uint32_t getWidth() const { return Width; }
+   [[nodiscard]] uint32_t getHeight() const { return Height; }
+   [[nodiscard]] uint32_t getMipLevels() const { return MipLevels; }
+   [[nodiscard]] VkFormat getFormat() const { return Format; }
+   [[nodiscard]] uint64_t getUploadTicket() const { return UploadTicket; }
+
+   // Moves are completed on the render thread, which is also where users subscribe and unsubscribe.
+   [[nodiscard]] uint64_t subscribeToMoves(std::function<void()> on_moved);
+   void unsubscribeFromMoves(uint64_t subscription);
+
+private:
+   uint32_t Width;
+   uint32_t Height;
+   uint32_t MipLevels;
+   VkFormat Format;
+   VkImage Image;
+   MemoryAllocatorVK::Allocation ImageMemory;
+   VkImageView ImageView;
+   VkComponentMapping Components;
+   uint64_t UploadTicket;
+   DefragmenterVK* Defragmenter;
+   uint64_t DefragmentationId;
+   std::map<uint64_t, std::function<void()>> MoveSubscribers;
+   uint64_t NextSubscription;
+
+   static void downsample(const uint8_t* src, uint32_t src_width, uint32_t src_height, bool srgb, uint8_t* dst);
+};
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ktx2_writer.h"
+#include "pixel_conversion.h"
+#include "thread_pool.h"
+
+// Hands out shared textures keyed by file path, and optionally by the hash of the decoded pixels so that the same image
+// stored under different paths is also loaded once. The cache only holds weak references; a texture is destroyed when
+// the last object using it goes away. KTX2 containers are read directly, other files through FreeImage. With a derived
+// data directory, decoded images are block-compressed and stored there as KTX2 files keyed by the hash of the source
+// file, so later runs load the compressed texture without decoding or encoding anything.
+// Decoding runs as jobs on the thread pool and each texture starts uploading as soon as its job is done. Requests for a
+// path that is still loading share the pending job. Textures are registered with the defragmenter when one is given.
+class TextureCacheVK final
+{
+public:
+   using TextureFuture = std::shared_future<std::shared_ptr<TextureVK>>;
+
+   TextureCacheVK(
+      AsyncUploaderVK* uploader,
+      ThreadPoolVK* thread_pool,
+      DefragmenterVK* defragmenter,
+      bool deduplicate_by_content,
+      std::string derived_data_directory = {}
+   );
+   ~TextureCacheVK() = default;
+
+   [[nodiscard]] TextureFuture loadAsync(const std::string& texture_file_path);
+   [[nodiscard]] std::shared_ptr<TextureVK> load(const std::string& texture_file_path)
+   {
+      return loadAsync( texture_file_path ).get();
+   }
+
+   // Only applies to images decoded through FreeImage, and only to the ones loaded after the call.
+   void setAlphaPremultiplication(bool premultiply_alpha) { PremultiplyAlpha = premultiply_alpha; }
+
+private:
+   // Bumped whenever the encoded data changes, so that stale derived files are not picked up. Version 2 encodes mip
+   // levels that were averaged in linear space.
+   inline static constexpr uint64_t DerivedDataVersion = 2;
+
+   AsyncUploaderVK* Uploader;
+   ThreadPoolVK* ThreadPool;
+   DefragmenterVK* Defragmenter;
+   bool DeduplicateByContent;
+   std::atomic<bool> PremultiplyAlpha;
+   std::string DerivedDataDirectory;
+   std::mutex Mutex;
+   std::unordered_map<std::string, std::weak_ptr<TextureVK>> PathEntries;
+   std::unordered_map<uint64_t, std::weak_ptr<TextureVK>> ContentEntries;
+   std::unordered_map<std::string, TextureFuture> PendingLoads;
+
+   [[nodiscard]] static uint64_t getContentHash(const TextureVK::ImageData& image_data);
+   [[nodiscard]] static uint64_t getFileHash(const std::string& file_path);
+   [[nodiscard]] TextureVK::ImageData loadWithFreeImage(const std::string& texture_file_path) const;
+   [[nodiscard]] static bool isGray(
+      const uint8_t* pixels,
+      size_t pitch,
+      uint32_t width,
+      uint32_t height,
+      uint32_t channels,
+      bool& opaque
+   );
+   [[nodiscard]] bool loadNarrowed(FIBITMAP* bitmap, TextureVK::ImageData& image_data) const;
+   [[nodiscard]] static VkFormat getCompressedFormat(const TextureVK::ImageData& image_data);
+   [[nodiscard]] TextureVK::ImageData loadCompressed(const std::string& texture_file_path) const;
+   [[nodiscard]] TextureVK::ImageData decode(const std::string& texture_file_path) const;
+   [[nodiscard]] std::shared_ptr<TextureVK> create(const std::string& key, TextureVK::ImageData image_data);
+   void removeExpiredEntries();
+};
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "base.h"
+
+// A fixed set of worker threads that run jobs in submission order. Jobs still queued when the pool is destroyed are run
+// before the workers are joined, so every future handed out gets its result.
+class ThreadPoolVK final
+{
+public:
+   explicit ThreadPoolVK(uint32_t thread_count);
+   ~ThreadPoolVK();
+
+   ThreadPoolVK(const ThreadPoolVK&) = delete;
+   ThreadPoolVK& operator=(const ThreadPoolVK&) = delete;
+
+   template<typename F>
+   [[nodiscard]] std::future<std::invoke_result_t<F>> submit(F&& job)
+   {
+      using R = std::invoke_result_t<F>;
+      auto task = std::make_shared<std::packaged_task<R()>>( std::forward<F>( job ) );
+      std::future<R> future = task->get_future();
+      {
+         std::lock_guard<std::mutex> lock( Mutex );
+         if (Stop) throw std::runtime_error("failed to submit a job to a stopped thread pool!");
+         Jobs.emplace_back( [task]() { (*task)(); } );
+      }
+      Condition.notify_one();
+      return future;
+   }
+   [[nodiscard]] uint32_t getThreadCount() const { return static_cast<uint32_t>(Workers.size()); }
+
+private:
+   std::vector<std::thread> Workers;
+   std::mutex Mutex;
+   std::condition_variable Condition;
+   std::deque<std::function<void()>> Jobs;
+   bool Stop;
+
+   void run();
+};
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "common.h"
+
+class UniformRingBufferVK final
+{
+public:
+   explicit UniformRingBufferVK(VkDeviceSize size_per_frame);
+   ~UniformRingBufferVK();
+
+   [[nodiscard]] VkBuffer getBuffer(uint32_t frame_index) const { return Buffers[frame_index]; }
+   [[nodiscard]] VkDeviceSize getSizePerFrame() const { return SizePerFrame; }
+   void beginFrame(uint32_t frame_index);
+   [[nodiscard]] uint32_t push(const void* data, VkDeviceSize size);
+   template<typename T>
+   [[nodiscard]] uint32_t push(const T& data) { return push( &data, sizeof( T ) ); }
+
+private:
+   VkDeviceSize Alignment;
+   VkDeviceSize SizePerFrame;
+   VkDeviceSize Head;
+   uint32_t CurrentFrame;
+   std::vector<VkBuffer> Buffers;
+   std::vector<MemoryAllocatorVK::Allocation> BuffersMemory;
+};
\ No newline at end of file
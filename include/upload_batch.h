@@ -0,0 +1,85 @@
+#pragma once
+
+#include "staging_ring.h"
+
+// Records the host-to-device copies of many resources into a single command buffer so that they cost one submission
+// in total. Completion is tracked by the timeline semaphore value the batch signals. Data is staged in the staging ring
+// when one is given; uploads that do not fit in it get temporary staging buffers, which stay alive until that value has
+// been reached.
+// When the batch runs on a queue family other than the one that uses the resources, it releases their ownership at the
+// end of the command buffer, and the matching acquire barriers have to be recorded on the destination queue.
+// Mip levels that are not part of the uploaded data are blitted from level 0; a transfer queue cannot blit, so in that
+// case the image is released in TRANSFER_DST_OPTIMAL and the destination queue has to generate them after the acquire.
+class UploadBatchVK final
+{
+public:
+   struct MipmapGeneration
+   {
+      VkImage Image;
+      uint32_t Width;
+      uint32_t Height;
+      uint32_t MipLevels;
+   };
+
+   UploadBatchVK(
+      VkCommandPool command_pool,
+      VkQueue queue,
+      uint32_t src_queue_family,
+      uint32_t dst_queue_family,
+      StagingRingVK* staging_ring = nullptr
+   );
+   ~UploadBatchVK();
+
+   void uploadBuffer(VkBuffer dst_buffer, const void* data, VkDeviceSize size, VkDeviceSize dst_offset = 0);
+   void uploadImage(
+      VkImage dst_image,
+      const void* data,
+      VkDeviceSize size,
+      uint32_t width,
+      uint32_t height,
+      uint32_t mip_levels = 1,
+      const std::vector<VkDeviceSize>& level_offsets = { 0 }
+   );
+   void submit(VkSemaphore timeline_semaphore, uint64_t signal_value);
+   [[nodiscard]] bool isComplete();
+   void wait();
+   [[nodiscard]] bool empty() const { return CommandBuffer == VK_NULL_HANDLE; }
+   [[nodiscard]] const std::vector<VkBufferMemoryBarrier>& getBufferAcquireBarriers() const
+   {
+      return BufferAcquireBarriers;
+   }
+   [[nodiscard]] const std::vector<VkImageMemoryBarrier>& getImageAcquireBarriers() const
+   {
+      return ImageAcquireBarriers;
+   }
+   [[nodiscard]] const std::vector<MipmapGeneration>& getMipmapGenerations() const { return MipmapGenerations; }
+
+private:
+   struct StagingBuffer
+   {
+      VkBuffer Buffer;
+      MemoryAllocatorVK::Allocation Memory;
+
+      StagingBuffer() : Buffer( VK_NULL_HANDLE ) {}
+   };
+
+   VkCommandPool CommandPool;
+   VkQueue Queue;
+   StagingRingVK* StagingRing;
+   uint32_t SrcQueueFamily;
+   uint32_t DstQueueFamily;
+   VkCommandBuffer CommandBuffer;
+   VkSemaphore TimelineSemaphore;
+   uint64_t SignalValue;
+   bool Submitted;
+   bool HasBufferUploads;
+   std::vector<StagingBuffer> StagingBuffers;
+   std::vector<VkBufferMemoryBarrier> BufferAcquireBarriers;
+   std::vector<VkImageMemoryBarrier> ImageAcquireBarriers;
+   std::vector<MipmapGeneration> MipmapGenerations;
+
+   [[nodiscard]] bool transfersOwnership() const { return SrcQueueFamily != DstQueueFamily; }
+   void beginRecording();
+   [[nodiscard]] StagingRingVK::Region stage(const void* data, VkDeviceSize size);
+   void release();
+};
\ No newline at end of file
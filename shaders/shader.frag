@@ -1,21 +1,11 @@
 #version 460
 
-layout (binding = 0) uniform MVP
+layout (set = 0, binding = 0) uniform Scene
 {
-    mat4 WorldMatrix;
     mat4 ViewMatrix;
     mat4 ProjectionMatrix;
-} mvp;
-layout (binding = 1) uniform sampler2D BaseTexture;
-layout (binding = 2) uniform MateralInfo
-{
-   vec4 EmissionColor;
-   vec4 AmbientColor;
-   vec4 DiffuseColor;
-   vec4 SpecularColor;
-   float SpecularExponent;
-} material;
-layout (binding = 3) uniform LightInfo
+} scene;
+layout (set = 0, binding = 1) uniform LightInfo
 {
    vec4 Position;
    vec4 AmbientColor;
@@ -27,6 +17,15 @@ layout (binding = 3) uniform LightInfo
    float SpotlightFeather;
    float FallOffRadius;
 } light;
+layout (set = 1, binding = 0) uniform MateralInfo
+{
+   vec4 EmissionColor;
+   vec4 AmbientColor;
+   vec4 DiffuseColor;
+   vec4 SpecularColor;
+   float SpecularExponent;
+} material;
+layout (set = 1, binding = 1) uniform sampler2D BaseTexture;
 
 layout (location = 0) in vec3 position_in_ec;
 layout (location = 1) in vec3 normal_in_ec;
@@ -58,7 +57,7 @@ float getSpotlightFactor(in vec3 normalized_light_vector)
 {
    if (light.SpotlightCutoffAngle >= 180.0f) return one;
 
-   vec4 direction_in_ec = transpose( inverse( mvp.ViewMatrix ) ) * vec4(light.SpotlightDirection, zero);
+   vec4 direction_in_ec = transpose( inverse( scene.ViewMatrix ) ) * vec4(light.SpotlightDirection, zero);
    vec3 normalized_direction = normalize( direction_in_ec.xyz );
    float factor = dot( -normalized_light_vector, normalized_direction );
    float cutoff_angle = radians( clamp( light.SpotlightCutoffAngle, zero, 90.0f ) );
@@ -74,7 +73,7 @@ float getSpotlightFactor(in vec3 normalized_light_vector)
 vec4 calculateLightingEquation()
 {
    vec4 color = material.EmissionColor + global_ambient_color * material.AmbientColor;
-   vec4 light_position_in_ec = mvp.ViewMatrix * light.Position;
+   vec4 light_position_in_ec = scene.ViewMatrix * light.Position;
    
    float final_effect_factor = one;
    vec3 light_vector = light_position_in_ec.xyz - position_in_ec;
@@ -106,6 +105,6 @@ vec4 calculateLightingEquation()
 
 void main()
 {
-   final_color = texture( BaseTexture, tex_coord ).bgra;
+   final_color = texture( BaseTexture, tex_coord );
    final_color *= calculateLightingEquation();
 }
\ No newline at end of file
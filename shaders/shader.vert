@@ -1,11 +1,14 @@
 #version 460
 
-layout (binding = 0) uniform MVP
+layout (set = 0, binding = 0) uniform Scene
 {
-    mat4 WorldMatrix;
     mat4 ViewMatrix;
     mat4 ProjectionMatrix;
-} mvp;
+} scene;
+layout (set = 2, binding = 0) uniform Object
+{
+    mat4 WorldMatrix;
+} object;
 
 layout (location = 0) in vec3 v_position;
 layout (location = 1) in vec3 v_normal;
@@ -17,12 +20,12 @@ layout (location = 2) out vec2 tex_coord;
 
 void main()
 {
-    vec4 e_position = mvp.ViewMatrix * mvp.WorldMatrix * vec4(v_position, 1.0f);
-    vec4 e_normal = transpose( inverse( mvp.ViewMatrix * mvp.WorldMatrix ) ) * vec4(v_normal, 1.0f);
+    vec4 e_position = scene.ViewMatrix * object.WorldMatrix * vec4(v_position, 1.0f);
+    vec4 e_normal = transpose( inverse( scene.ViewMatrix * object.WorldMatrix ) ) * vec4(v_normal, 1.0f);
     position_in_ec = e_position.xyz;
     normal_in_ec = normalize( e_normal.xyz );
 
     tex_coord = v_tex_coord;
 
-    gl_Position = mvp.ProjectionMatrix * mvp.ViewMatrix * mvp.WorldMatrix * vec4(v_position, 1.0);
+    gl_Position = scene.ProjectionMatrix * scene.ViewMatrix * object.WorldMatrix * vec4(v_position, 1.0);
 }
\ No newline at end of file
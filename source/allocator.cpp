@@ -0,0 +1,501 @@
+#include "allocator.h"
+
+MemoryAllocatorVK::MemoryAllocatorVK(VkPhysicalDevice physical_device, VkDevice device, bool memory_budget_supported) :
+   PhysicalDevice( physical_device ), Device( device ), MemoryProperties{}, BufferImageGranularity( 1 ),
+   DedicatedAllocationCount( 0 ), DedicatedBytes( 0 ), MemoryBudgetSupported( memory_budget_supported ),
+   OperationsSinceBudgetFetch( 0 )
+{
+   vkGetPhysicalDeviceMemoryProperties( physical_device, &MemoryProperties );
+
+   VkPhysicalDeviceProperties properties{};
+   vkGetPhysicalDeviceProperties( physical_device, &properties );
+   BufferImageGranularity = std::max<VkDeviceSize>( properties.limits.bufferImageGranularity, 1 );
+
+   Pools.resize( MemoryProperties.memoryTypeCount * 2 );
+   Bandwidths.resize( MemoryProperties.memoryTypeCount );
+   HeapAllocatedBytes.resize( MemoryProperties.memoryHeapCount, 0 );
+   HeapAllocatedBytesAtFetch.resize( MemoryProperties.memoryHeapCount, 0 );
+   FetchedHeapUsage.resize( MemoryProperties.memoryHeapCount, 0 );
+   FetchedHeapBudget.resize( MemoryProperties.memoryHeapCount, 0 );
+   fetchBudgets();
+}
+
+MemoryAllocatorVK::~MemoryAllocatorVK()
+{
+   for (uint32_t pool_index = 0; pool_index < Pools.size(); ++pool_index) {
+      for (auto& block : Pools[pool_index]) {
+         freeDeviceMemory( block->Memory, block->Size, pool_index / 2, block->MappedData != nullptr );
+      }
+   }
+   if (DedicatedAllocationCount > 0) {
+      std::cerr << "memory allocator: " << DedicatedAllocationCount << " dedicated allocations were not freed\n";
+   }
+}
+
+// Every type that has the required flags is scored: each preferred flag outweighs any avoided one, and measured
+// bandwidth and then heap size break ties. Types for special purposes, like lazily allocated or protected memory, are
+// never used.
+uint32_t MemoryAllocatorVK::findMemoryType(uint32_t type_filter, Usage usage) const
+{
+   constexpr VkMemoryPropertyFlags mappable =
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+   constexpr VkMemoryPropertyFlags excluded =
+      VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT | VK_MEMORY_PROPERTY_PROTECTED_BIT |
+      VK_MEMORY_PROPERTY_DEVICE_COHERENT_BIT_AMD | VK_MEMORY_PROPERTY_DEVICE_UNCACHED_BIT_AMD;
+   VkMemoryPropertyFlags required = 0;
+   VkMemoryPropertyFlags preferred = 0;
+   VkMemoryPropertyFlags avoided = 0;
+   switch (usage) {
+      case Usage::GpuOnly:
+         preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+         avoided = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+         break;
+      case Usage::Staging:
+         required = mappable;
+         avoided = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+         break;
+      case Usage::CpuToGpu:
+         required = mappable;
+         preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+         avoided = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+         break;
+      case Usage::GpuToCpu:
+         required = mappable;
+         preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+         avoided = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+         break;
+   }
+
+   const auto count_flags = [](VkMemoryPropertyFlags flags) {
+      return static_cast<int>(std::bitset<32>( flags ).count());
+   };
+   uint32_t best_type = MemoryProperties.memoryTypeCount;
+   std::tuple<int, double, VkDeviceSize> best_score{};
+   for (uint32_t i = 0; i < MemoryProperties.memoryTypeCount; ++i) {
+      const VkMemoryPropertyFlags flags = MemoryProperties.memoryTypes[i].propertyFlags;
+      if ((type_filter & (1u << i)) == 0 || (flags & required) != required || (flags & excluded) != 0) continue;
+
+      const double bandwidth = usage == Usage::GpuToCpu ? Bandwidths[i].Read :
+         usage == Usage::GpuOnly ? 0.0 : Bandwidths[i].Write;
+      const std::tuple<int, double, VkDeviceSize> score(
+         count_flags( flags & preferred ) * 8 - count_flags( flags & avoided ),
+         bandwidth,
+         MemoryProperties.memoryHeaps[MemoryProperties.memoryTypes[i].heapIndex].size
+      );
+      if (best_type == MemoryProperties.memoryTypeCount || score > best_score) {
+         best_type = i;
+         best_score = score;
+      }
+   }
+   if (best_type == MemoryProperties.memoryTypeCount) throw std::runtime_error("failed to find suitable memory type!");
+   return best_type;
+}
+
+// Times sequential host writes to and reads from a scratch allocation of every host-visible type. Reads from memory
+// that is not HOST_CACHED are usually an order of magnitude slower, which is what readback buffers have to avoid.
+void MemoryAllocatorVK::benchmarkMemoryTypes(std::ostream& stream)
+{
+   constexpr int repeats = 4;
+   std::vector<uint8_t> host_data( static_cast<size_t>(BenchmarkSize), 1 );
+   const auto measure = [&](const auto& copy) {
+      double best_seconds = std::numeric_limits<double>::max();
+      for (int i = 0; i < repeats; ++i) {
+         const auto start = std::chrono::steady_clock::now();
+         copy();
+         const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+         best_seconds = std::min( best_seconds, elapsed.count() );
+      }
+      return static_cast<double>(BenchmarkSize) / std::max( best_seconds, 1e-9 );
+   };
+
+   for (uint32_t i = 0; i < MemoryProperties.memoryTypeCount; ++i) {
+      const VkDeviceSize heap_size = MemoryProperties.memoryHeaps[MemoryProperties.memoryTypes[i].heapIndex].size;
+      if (!isHostVisible( i ) || BenchmarkSize > heap_size / 4) continue;
+
+      void* mapped_data = nullptr;
+      VkDeviceMemory memory = allocateDeviceMemory( BenchmarkSize, i, &mapped_data );
+      if (memory == VK_NULL_HANDLE) continue;
+
+      auto* mapped_bytes = static_cast<uint8_t*>(mapped_data);
+      Bandwidths[i].Write = measure( [&]() { std::memcpy( mapped_bytes, host_data.data(), host_data.size() ); } );
+      Bandwidths[i].Read = measure( [&]() { std::memcpy( host_data.data(), mapped_bytes, host_data.size() ); } );
+      freeDeviceMemory( memory, BenchmarkSize, i, true );
+
+      const VkMemoryPropertyFlags flags = MemoryProperties.memoryTypes[i].propertyFlags;
+      stream << "memory type " << i << " (heap " << MemoryProperties.memoryTypes[i].heapIndex
+         << ((flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) ? ", device-local" : "")
+         << ((flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) ? ", coherent" : "")
+         << ((flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) ? ", cached" : "") << "): "
+         << std::fixed << std::setprecision( 2 )
+         << Bandwidths[i].Write / (1024.0 * 1024.0 * 1024.0) << " GiB/s write, "
+         << Bandwidths[i].Read / (1024.0 * 1024.0 * 1024.0) << " GiB/s read\n";
+   }
+}
+
+VkDeviceSize MemoryAllocatorVK::getPreferredBlockSize(uint32_t memory_type_index) const
+{
+   const uint32_t heap_index = MemoryProperties.memoryTypes[memory_type_index].heapIndex;
+   const VkDeviceSize heap_size = MemoryProperties.memoryHeaps[heap_index].size;
+   return heap_size <= SmallHeapSize ? heap_size / 8 : DefaultBlockSize;
+}
+
+void MemoryAllocatorVK::fetchBudgets()
+{
+   OperationsSinceBudgetFetch = 0;
+   if (!MemoryBudgetSupported) return;
+
+   VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties{};
+   budget_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+   VkPhysicalDeviceMemoryProperties2 memory_properties{};
+   memory_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+   memory_properties.pNext = &budget_properties;
+   vkGetPhysicalDeviceMemoryProperties2( PhysicalDevice, &memory_properties );
+   for (uint32_t i = 0; i < MemoryProperties.memoryHeapCount; ++i) {
+      FetchedHeapUsage[i] = budget_properties.heapUsage[i];
+      FetchedHeapBudget[i] = budget_properties.heapBudget[i];
+      HeapAllocatedBytesAtFetch[i] = HeapAllocatedBytes[i];
+   }
+}
+
+// Without VK_EXT_memory_budget, only this allocator's own allocations are counted against 80% of the heap, which leaves
+// room for the driver and other processes.
+MemoryAllocatorVK::HeapBudget MemoryAllocatorVK::getHeapBudget(uint32_t heap_index) const
+{
+   HeapBudget budget;
+   budget.Size = MemoryProperties.memoryHeaps[heap_index].size;
+   if (MemoryBudgetSupported) {
+      const VkDeviceSize allocated = HeapAllocatedBytes[heap_index];
+      const VkDeviceSize allocated_at_fetch = HeapAllocatedBytesAtFetch[heap_index];
+      budget.Usage = allocated >= allocated_at_fetch ?
+         FetchedHeapUsage[heap_index] + (allocated - allocated_at_fetch) :
+         FetchedHeapUsage[heap_index] - std::min( FetchedHeapUsage[heap_index], allocated_at_fetch - allocated );
+      budget.Budget = std::min( FetchedHeapBudget[heap_index], budget.Size );
+   }
+   else {
+      budget.Usage = HeapAllocatedBytes[heap_index];
+      budget.Budget = budget.Size / 5 * 4;
+   }
+   return budget;
+}
+
+// Empty blocks that pools keep around for reuse are given back before an allocation is refused.
+bool MemoryAllocatorVK::fitsInBudget(uint32_t heap_index, VkDeviceSize size)
+{
+   if (++OperationsSinceBudgetFetch >= BudgetFetchInterval) fetchBudgets();
+
+   HeapBudget budget = getHeapBudget( heap_index );
+   if (budget.Usage + size <= budget.Budget) return true;
+
+   releaseEmptyBlocks( heap_index );
+   budget = getHeapBudget( heap_index );
+   return budget.Usage + size <= budget.Budget;
+}
+
+void MemoryAllocatorVK::releaseEmptyBlocks(uint32_t heap_index)
+{
+   for (uint32_t pool_index = 0; pool_index < Pools.size(); ++pool_index) {
+      const uint32_t memory_type_index = pool_index / 2;
+      if (getHeapIndex( memory_type_index ) != heap_index) continue;
+
+      auto& pool = Pools[pool_index];
+      for (auto it = pool.begin(); it != pool.end();) {
+         if ((*it)->AllocationCount == 0) {
+            freeDeviceMemory( (*it)->Memory, (*it)->Size, memory_type_index, (*it)->MappedData != nullptr );
+            it = pool.erase( it );
+         }
+         else ++it;
+      }
+   }
+}
+
+// Returns VK_NULL_HANDLE when the device refuses the allocation or when it would go over the budget of the heap.
+VkDeviceMemory MemoryAllocatorVK::allocateDeviceMemory(
+   VkDeviceSize size,
+   uint32_t memory_type_index,
+   void** mapped_data
+)
+{
+   if (!fitsInBudget( getHeapIndex( memory_type_index ), size )) return VK_NULL_HANDLE;
+
+   VkMemoryAllocateInfo allocate_info{};
+   allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+   allocate_info.allocationSize = size;
+   allocate_info.memoryTypeIndex = memory_type_index;
+
+   VkDeviceMemory memory = VK_NULL_HANDLE;
+   if (vkAllocateMemory( Device, &allocate_info, nullptr, &memory ) != VK_SUCCESS) return VK_NULL_HANDLE;
+
+   *mapped_data = nullptr;
+   if (isHostVisible( memory_type_index )) {
+      if (vkMapMemory( Device, memory, 0, VK_WHOLE_SIZE, 0, mapped_data ) != VK_SUCCESS) {
+         vkFreeMemory( Device, memory, nullptr );
+         throw std::runtime_error("failed to map device memory!");
+      }
+   }
+   HeapAllocatedBytes[getHeapIndex( memory_type_index )] += size;
+   return memory;
+}
+
+void MemoryAllocatorVK::freeDeviceMemory(
+   VkDeviceMemory memory,
+   VkDeviceSize size,
+   uint32_t memory_type_index,
+   bool mapped
+)
+{
+   if (mapped) vkUnmapMemory( Device, memory );
+   vkFreeMemory( Device, memory, nullptr );
+   HeapAllocatedBytes[getHeapIndex( memory_type_index )] -= size;
+   OperationsSinceBudgetFetch++;
+}
+
+bool MemoryAllocatorVK::allocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+   for (auto it = block.FreeRanges.begin(); it != block.FreeRanges.end(); ++it) {
+      const VkDeviceSize range_offset = it->first;
+      const VkDeviceSize range_size = it->second;
+      const VkDeviceSize aligned_offset = (range_offset + alignment - 1) / alignment * alignment;
+      if (aligned_offset + size > range_offset + range_size) continue;
+
+      block.FreeRanges.erase( it );
+      if (aligned_offset > range_offset) block.FreeRanges.emplace( range_offset, aligned_offset - range_offset );
+      const VkDeviceSize end = aligned_offset + size;
+      if (end < range_offset + range_size) block.FreeRanges.emplace( end, range_offset + range_size - end );
+
+      offset = aligned_offset;
+      block.AllocationCount++;
+      return true;
+   }
+   return false;
+}
+
+void MemoryAllocatorVK::freeToBlock(Block& block, VkDeviceSize offset, VkDeviceSize size)
+{
+   auto it = block.FreeRanges.emplace( offset, size ).first;
+
+   auto next = std::next( it );
+   if (next != block.FreeRanges.end() && it->first + it->second == next->first) {
+      it->second += next->second;
+      block.FreeRanges.erase( next );
+   }
+   if (it != block.FreeRanges.begin()) {
+      auto previous = std::prev( it );
+      if (previous->first + previous->second == it->first) {
+         previous->second += it->second;
+         block.FreeRanges.erase( it );
+      }
+   }
+   block.AllocationCount--;
+}
+
+MemoryAllocatorVK::Allocation MemoryAllocatorVK::allocateDedicated(VkDeviceSize size, uint32_t memory_type_index)
+{
+   Allocation allocation;
+   allocation.Memory = allocateDeviceMemory( size, memory_type_index, &allocation.MappedData );
+   if (allocation.Memory == VK_NULL_HANDLE) throw std::runtime_error("failed to allocate dedicated device memory!");
+
+   allocation.Offset = 0;
+   allocation.Size = size;
+   allocation.MemoryTypeIndex = memory_type_index;
+   allocation.Dedicated = true;
+   DedicatedAllocationCount++;
+   DedicatedBytes += size;
+   return allocation;
+}
+
+MemoryAllocatorVK::Allocation MemoryAllocatorVK::allocate(
+   const VkMemoryRequirements& requirements,
+   uint32_t memory_type_index,
+   bool linear_resource
+)
+{
+   std::lock_guard<std::mutex> lock( Mutex );
+
+   // Resources that would take up a large part of a block get their own VkDeviceMemory instead of splintering it.
+   const VkDeviceSize block_size = getPreferredBlockSize( memory_type_index );
+   if (requirements.size > block_size / 2) return allocateDedicated( requirements.size, memory_type_index );
+
+   const uint32_t pool_index = memory_type_index * 2 + (linear_resource || BufferImageGranularity == 1 ? 0 : 1);
+   auto& pool = Pools[pool_index];
+
+   Allocation allocation;
+   allocation.Size = requirements.size;
+   allocation.MemoryTypeIndex = memory_type_index;
+   allocation.PoolIndex = pool_index;
+   for (auto& block : pool) {
+      if (allocateFromBlock( *block, requirements.size, requirements.alignment, allocation.Offset )) {
+         allocation.Memory = block->Memory;
+         if (block->MappedData != nullptr) {
+            allocation.MappedData = static_cast<uint8_t*>(block->MappedData) + allocation.Offset;
+         }
+         return allocation;
+      }
+   }
+
+   // When the device refuses a full-sized block, retry with smaller ones before falling back to a dedicated allocation.
+   auto block = std::make_unique<Block>();
+   for (VkDeviceSize size = block_size; size >= requirements.size; size /= 2) {
+      block->Memory = allocateDeviceMemory( size, memory_type_index, &block->MappedData );
+      if (block->Memory != VK_NULL_HANDLE) {
+         block->Size = size;
+         break;
+      }
+   }
+   if (block->Memory == VK_NULL_HANDLE) return allocateDedicated( requirements.size, memory_type_index );
+
+   block->FreeRanges.emplace( 0, block->Size );
+   allocateFromBlock( *block, requirements.size, requirements.alignment, allocation.Offset );
+   allocation.Memory = block->Memory;
+   if (block->MappedData != nullptr) {
+      allocation.MappedData = static_cast<uint8_t*>(block->MappedData) + allocation.Offset;
+   }
+   pool.emplace_back( std::move( block ) );
+   return allocation;
+}
+
+void MemoryAllocatorVK::free(Allocation& allocation)
+{
+   if (!allocation.isValid()) return;
+
+   std::lock_guard<std::mutex> lock( Mutex );
+   if (allocation.Dedicated) {
+      freeDeviceMemory(
+         allocation.Memory, allocation.Size, allocation.MemoryTypeIndex, allocation.MappedData != nullptr
+      );
+      DedicatedAllocationCount--;
+      DedicatedBytes -= allocation.Size;
+      allocation = Allocation();
+      return;
+   }
+
+   auto& pool = Pools[allocation.PoolIndex];
+   const auto it = std::find_if(
+      pool.begin(), pool.end(),
+      [&allocation](const std::unique_ptr<Block>& block) { return block->Memory == allocation.Memory; }
+   );
+   if (it == pool.end()) throw std::runtime_error("failed to find the memory block of an allocation!");
+
+   freeToBlock( **it, allocation.Offset, allocation.Size );
+
+   // One empty block per pool is kept around so that a create/destroy cycle does not hit vkAllocateMemory every time.
+   if ((*it)->AllocationCount == 0 && pool.size() > 1) {
+      freeDeviceMemory( (*it)->Memory, (*it)->Size, allocation.MemoryTypeIndex, (*it)->MappedData != nullptr );
+      pool.erase( it );
+   }
+   allocation = Allocation();
+}
+
+MemoryAllocatorVK::Block* MemoryAllocatorVK::findBlock(uint32_t pool_index, VkDeviceMemory memory) const
+{
+   for (const auto& block : Pools[pool_index]) {
+      if (block->Memory == memory) return block.get();
+   }
+   throw std::runtime_error("failed to find the memory block of an allocation!");
+}
+
+VkDeviceSize MemoryAllocatorVK::getUsedBytes(const Block& block)
+{
+   VkDeviceSize free_bytes = 0;
+   for (const auto& range : block.FreeRanges) free_bytes += range.second;
+   return block.Size - free_bytes;
+}
+
+float MemoryAllocatorVK::getBlockOccupancy(const Allocation& allocation) const
+{
+   if (allocation.Dedicated) return 1.0f;
+
+   std::lock_guard<std::mutex> lock( Mutex );
+   const Block* block = findBlock( allocation.PoolIndex, allocation.Memory );
+   return static_cast<float>(getUsedBytes( *block )) / static_cast<float>(block->Size);
+}
+
+MemoryAllocatorVK::Allocation MemoryAllocatorVK::allocateForMove(
+   const VkMemoryRequirements& requirements,
+   const Allocation& source
+)
+{
+   Allocation allocation;
+   if (source.Dedicated) return allocation;
+
+   std::lock_guard<std::mutex> lock( Mutex );
+   const VkDeviceSize source_used_bytes = getUsedBytes( *findBlock( source.PoolIndex, source.Memory ) );
+   std::vector<std::pair<VkDeviceSize, Block*>> targets;
+   for (const auto& block : Pools[source.PoolIndex]) {
+      const VkDeviceSize used_bytes = getUsedBytes( *block );
+      if (block->Memory != source.Memory && used_bytes > source_used_bytes) {
+         targets.emplace_back( used_bytes, block.get() );
+      }
+   }
+   std::sort(
+      targets.begin(), targets.end(),
+      [](const auto& a, const auto& b) { return a.first > b.first; }
+   );
+
+   for (const auto& target : targets) {
+      Block& block = *target.second;
+      if (allocateFromBlock( block, requirements.size, requirements.alignment, allocation.Offset )) {
+         allocation.Memory = block.Memory;
+         allocation.Size = requirements.size;
+         allocation.MemoryTypeIndex = source.MemoryTypeIndex;
+         allocation.PoolIndex = source.PoolIndex;
+         if (block.MappedData != nullptr) {
+            allocation.MappedData = static_cast<uint8_t*>(block.MappedData) + allocation.Offset;
+         }
+         return allocation;
+      }
+   }
+   return allocation;
+}
+
+MemoryAllocatorVK::Statistics MemoryAllocatorVK::getStatistics() const
+{
+   std::lock_guard<std::mutex> lock( Mutex );
+   Statistics statistics;
+   statistics.DedicatedAllocationCount = DedicatedAllocationCount;
+   statistics.DedicatedBytes = DedicatedBytes;
+   for (const auto& pool : Pools) {
+      for (const auto& block : pool) {
+         statistics.BlockCount++;
+         statistics.AllocationCount += block->AllocationCount;
+         statistics.BlockBytes += block->Size;
+
+         VkDeviceSize free_bytes = 0;
+         for (const auto& range : block->FreeRanges) {
+            free_bytes += range.second;
+            statistics.LargestFreeRange = std::max( statistics.LargestFreeRange, range.second );
+         }
+         statistics.FreeRangeCount += static_cast<uint32_t>(block->FreeRanges.size());
+         statistics.UsedBytes += block->Size - free_bytes;
+      }
+   }
+   return statistics;
+}
+
+void MemoryAllocatorVK::printStatistics(std::ostream& stream) const
+{
+   const Statistics statistics = getStatistics();
+   stream << "memory allocator: "
+      << statistics.BlockCount << " blocks (" << statistics.BlockBytes / 1024 << " KiB, "
+      << statistics.UsedBytes / 1024 << " KiB used by " << statistics.AllocationCount << " allocations), "
+      << statistics.DedicatedAllocationCount << " dedicated (" << statistics.DedicatedBytes / 1024 << " KiB), "
+      << statistics.FreeRangeCount << " free ranges, fragmentation "
+      << std::fixed << std::setprecision( 2 ) << statistics.getFragmentation() << "\n";
+}
+
+std::vector<MemoryAllocatorVK::HeapBudget> MemoryAllocatorVK::getHeapBudgets()
+{
+   std::lock_guard<std::mutex> lock( Mutex );
+   fetchBudgets();
+   std::vector<HeapBudget> budgets( MemoryProperties.memoryHeapCount );
+   for (uint32_t i = 0; i < MemoryProperties.memoryHeapCount; ++i) budgets[i] = getHeapBudget( i );
+   return budgets;
+}
+
+void MemoryAllocatorVK::printHeapBudgets(std::ostream& stream)
+{
+   const std::vector<HeapBudget> budgets = getHeapBudgets();
+   for (size_t i = 0; i < budgets.size(); ++i) {
+      stream << "memory heap " << i << ": " << budgets[i].Usage / (1024 * 1024) << " MiB used of "
+         << budgets[i].Budget / (1024 * 1024) << " MiB budget (" << budgets[i].Size / (1024 * 1024) << " MiB heap)\n";
+   }
+}
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "async_uploader.h"
+
+AsyncUploaderVK::AsyncUploaderVK(VkDeviceSize staging_ring_size) :
+   CommandPool( VK_NULL_HANDLE ), TimelineSemaphore( VK_NULL_HANDLE ), Stop( false ), NextValue( 1 ), AcquiredValue( 0 )
+{
+   VkCommandPoolCreateInfo pool_info{};
+   pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+   pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+   pool_info.queueFamilyIndex = CommonVK::getTransferQueueFamily();
+   VkResult result = vkCreateCommandPool(
+      CommonVK::getDevice(),
+      &pool_info,
+      nullptr,
+      &CommandPool
+   );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to create upload command pool!");
+
+   VkSemaphoreTypeCreateInfo type_info{};
+   type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+   type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+   type_info.initialValue = 0;
+
+   VkSemaphoreCreateInfo semaphore_info{};
+   semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+   semaphore_info.pNext = &type_info;
+   result = vkCreateSemaphore(
+      CommonVK::getDevice(),
+      &semaphore_info,
+      nullptr,
+      &TimelineSemaphore
+   );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to create upload timeline semaphore!");
+
+   StagingRing = std::make_unique<StagingRingVK>( staging_ring_size, TimelineSemaphore );
+
+   Worker = std::thread( &AsyncUploaderVK::run, this );
+}
+
+AsyncUploaderVK::~AsyncUploaderVK()
+{
+   {
+      std::lock_guard<std::mutex> lock( Mutex );
+      Stop = true;
+   }
+   Condition.notify_one();
+   if (Worker.joinable()) Worker.join();
+
+   for (auto& submission : InFlight) submission.Batch->wait();
+   InFlight.clear();
+   StagingRing.reset();
+
+   VkDevice device = CommonVK::getDevice();
+   vkDestroySemaphore( device, TimelineSemaphore, nullptr );
+   vkDestroyCommandPool( device, CommandPool, nullptr );
+}
+
+uint64_t AsyncUploaderVK::enqueue(Request&& request)
+{
+   uint64_t ticket;
+   {
+      std::lock_guard<std::mutex> lock( Mutex );
+      Requests.emplace_back( std::move( request ) );
+      ticket = NextValue;
+   }
+   Condition.notify_one();
+   return ticket;
+}
+
+uint64_t AsyncUploaderVK::uploadBuffer(VkBuffer dst_buffer, std::vector<uint8_t> data)
+{
+   Request request;
+   request.Buffer = dst_buffer;
+   request.Data = std::move( data );
+   return enqueue( std::move( request ) );
+}
+
+uint64_t AsyncUploaderVK::uploadImage(
+   VkImage dst_image,
+   std::vector<uint8_t> data,
+   uint32_t width,
+   uint32_t height,
+   uint32_t mip_levels,
+   std::vector<VkDeviceSize> level_offsets
+)
+{
+   Request request;
+   request.Image = dst_image;
+   request.Data = std::move( data );
+   request.LevelOffsets = std::move( level_offsets );
+   request.Width = width;
+   request.Height = height;
+   request.MipLevels = mip_levels;
+   return enqueue( std::move( request ) );
+}
+
+void AsyncUploaderVK::run()
+{
+   while (true) {
+      std::vector<Request> requests;
+      uint64_t value = 0;
+      bool stop;
+      {
+         std::unique_lock<std::mutex> lock( Mutex );
+         const auto has_work = [this]() { return Stop || !Requests.empty(); };
+
+         // While batches are in flight, wake up now and then to hand their staging memory back.
+         if (InFlight.empty()) Condition.wait( lock, has_work );
+         else Condition.wait_for( lock, std::chrono::milliseconds( 1 ), has_work );
+
+         stop = Stop;
+         if (!Requests.empty()) {
+            requests.swap( Requests );
+            value = NextValue++;
+         }
+      }
+
+      if (!requests.empty()) submit( requests, value );
+      reclaim();
+      if (stop) return;
+   }
+}
+
+void AsyncUploaderVK::submit(std::vector<Request>& requests, uint64_t value)
+{
+   auto batch = std::make_unique<UploadBatchVK>(
+      CommandPool,
+      CommonVK::getTransferQueue(),
+      CommonVK::getTransferQueueFamily(),
+      CommonVK::getGraphicsQueueFamily(),
+      StagingRing.get()
+   );
+   for (auto& request : requests) {
+      const auto size = static_cast<VkDeviceSize>(request.Data.size());
+      if (request.Image != VK_NULL_HANDLE) {
+         batch->uploadImage(
+            request.Image, request.Data.data(), size,
+            request.Width, request.Height, request.MipLevels, request.LevelOffsets
+         );
+      }
+      else batch->uploadBuffer( request.Buffer, request.Data.data(), size );
+   }
+   batch->submit( TimelineSemaphore, value );
+
+   PendingAcquire pending_acquire;
+   pending_acquire.BufferBarriers = batch->getBufferAcquireBarriers();
+   pending_acquire.ImageBarriers = batch->getImageAcquireBarriers();
+   pending_acquire.MipmapGenerations = batch->getMipmapGenerations();
+   pending_acquire.Value = value;
+   {
+      std::lock_guard<std::mutex> lock( Mutex );
+      PendingAcquires.emplace_back( std::move( pending_acquire ) );
+   }
+   InFlight.push_back( { std::move( batch ), value } );
+}
+
+void AsyncUploaderVK::reclaim()
+{
+   if (InFlight.empty()) return;
+
+   uint64_t completed_value = 0;
+   vkGetSemaphoreCounterValue( CommonVK::getDevice(), TimelineSemaphore, &completed_value );
+   for (auto it = InFlight.begin(); it != InFlight.end();) {
+      if (it->Value <= completed_value && it->Batch->isComplete()) it = InFlight.erase( it );
+      else ++it;
+   }
+}
+
+uint64_t AsyncUploaderVK::acquire(VkCommandBuffer command_buffer)
+{
+   std::vector<PendingAcquire> pending_acquires;
+   {
+      std::lock_guard<std::mutex> lock( Mutex );
+      pending_acquires.swap( PendingAcquires );
+   }
+   if (pending_acquires.empty()) return 0;
+
+   std::vector<VkBufferMemoryBarrier> buffer_barriers;
+   std::vector<VkImageMemoryBarrier> image_barriers;
+   std::vector<UploadBatchVK::MipmapGeneration> mipmap_generations;
+   uint64_t wait_value = 0;
+   for (const auto& pending_acquire : pending_acquires) {
+      buffer_barriers.insert(
+         buffer_barriers.end(),
+         pending_acquire.BufferBarriers.begin(), pending_acquire.BufferBarriers.end()
+      );
+      image_barriers.insert(
+         image_barriers.end(),
+         pending_acquire.ImageBarriers.begin(), pending_acquire.ImageBarriers.end()
+      );
+      mipmap_generations.insert(
+         mipmap_generations.end(),
+         pending_acquire.MipmapGenerations.begin(), pending_acquire.MipmapGenerations.end()
+      );
+      wait_value = std::max( wait_value, pending_acquire.Value );
+   }
+
+   // Without a transfer family there is nothing to acquire; the timeline wait alone orders the copies before the draws.
+   if (!buffer_barriers.empty() || !image_barriers.empty()) {
+      vkCmdPipelineBarrier(
+         command_buffer,
+         getAcquireStages(),
+         getAcquireStages(),
+         0,
+         0, nullptr,
+         static_cast<uint32_t>(buffer_barriers.size()), buffer_barriers.data(),
+         static_cast<uint32_t>(image_barriers.size()), image_barriers.data()
+      );
+   }
+   for (const auto& generation : mipmap_generations) {
+      CommonVK::generateMipmaps(
+         command_buffer, generation.Image, generation.Width, generation.Height, generation.MipLevels
+      );
+   }
+   AcquiredValue = std::max( AcquiredValue, wait_value );
+   return wait_value;
+}
\ No newline at end of file
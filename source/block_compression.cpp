@@ -0,0 +1,667 @@
+#include "block_compression.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BLOCK_COMPRESSION_USE_SSE2
+#endif
+
+const BlockCompressionVK::BC7Mode BlockCompressionVK::BC7Modes[8] = {
+   { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+   { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+   { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+   { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+   { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+   { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+   { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+   { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+};
+
+// Bit i is the subset of texel i.
+const uint16_t BlockCompressionVK::BC7Partitions2[64] = {
+   0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+   0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+   0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+   0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+   0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+   0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+   0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+   0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22
+};
+
+const uint8_t BlockCompressionVK::BC7Partitions3[64][16] = {
+   { 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
+   { 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1 },
+   { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2 },
+   { 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 }, { 0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+   { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2 }, { 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 },
+   { 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2 },
+   { 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2 }, { 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2 },
+   { 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0 },
+   { 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2 }, { 0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0 },
+   { 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1 },
+   { 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1 },
+   { 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2 }, { 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0 },
+   { 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0 }, { 0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2 },
+   { 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0 }, { 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1 },
+   { 0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2 }, { 0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2 },
+   { 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1 }, { 0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1 },
+   { 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1 },
+   { 0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2 }, { 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0 },
+   { 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0 }, { 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+   { 0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0 }, { 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 },
+   { 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1 }, { 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+   { 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1 }, { 0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2 },
+   { 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1 }, { 0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1 },
+   { 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1 }, { 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1 },
+   { 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 }, { 0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1 },
+   { 0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2 }, { 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2 },
+   { 0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2 }, { 0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2 },
+   { 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2 },
+   { 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2 },
+   { 0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2 },
+   { 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1 }, { 0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2 },
+   { 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0 }
+};
+
+const uint8_t BlockCompressionVK::BC7Anchors2[64] = {
+   15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+   15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+   15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+    6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15
+};
+
+const uint8_t BlockCompressionVK::BC7Anchors3[2][64] = {
+   {
+       3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+       3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+       8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+       3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3
+   },
+   {
+      15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+      15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+      15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+      15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8
+   }
+};
+
+bool BlockCompressionVK::isBlockCompressed(VkFormat format)
+{
+   return getBlockSize( format ) != 0;
+}
+
+bool BlockCompressionVK::isSRGB(VkFormat format)
+{
+   switch (format) {
+      case VK_FORMAT_R8G8B8A8_SRGB:
+      case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+      case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+      case VK_FORMAT_BC3_SRGB_BLOCK:
+      case VK_FORMAT_BC7_SRGB_BLOCK:
+      case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+      case VK_FORMAT_ASTC_6x6_SRGB_BLOCK:
+      case VK_FORMAT_ASTC_8x8_SRGB_BLOCK:
+         return true;
+      default:
+         return false;
+   }
+}
+
+uint32_t BlockCompressionVK::getBlockWidth(VkFormat format)
+{
+   switch (format) {
+      case VK_FORMAT_ASTC_6x6_UNORM_BLOCK:
+      case VK_FORMAT_ASTC_6x6_SRGB_BLOCK:
+         return 6;
+      case VK_FORMAT_ASTC_8x8_UNORM_BLOCK:
+      case VK_FORMAT_ASTC_8x8_SRGB_BLOCK:
+         return 8;
+      default:
+         return isBlockCompressed( format ) ? 4 : 1;
+   }
+}
+
+uint32_t BlockCompressionVK::getBlockHeight(VkFormat format)
+{
+   return getBlockWidth( format );
+}
+
+uint32_t BlockCompressionVK::getBlockSize(VkFormat format)
+{
+   switch (format) {
+      case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+      case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+      case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+      case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+         return 8;
+      case VK_FORMAT_BC3_UNORM_BLOCK:
+      case VK_FORMAT_BC3_SRGB_BLOCK:
+      case VK_FORMAT_BC7_UNORM_BLOCK:
+      case VK_FORMAT_BC7_SRGB_BLOCK:
+      case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+      case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+      case VK_FORMAT_ASTC_6x6_UNORM_BLOCK:
+      case VK_FORMAT_ASTC_6x6_SRGB_BLOCK:
+      case VK_FORMAT_ASTC_8x8_UNORM_BLOCK:
+      case VK_FORMAT_ASTC_8x8_SRGB_BLOCK:
+         return 16;
+      default:
+         return 0;
+   }
+}
+
+VkDeviceSize BlockCompressionVK::getLevelSize(VkFormat format, uint32_t width, uint32_t height)
+{
+   if (!isBlockCompressed( format )) return static_cast<VkDeviceSize>(width) * height * 4;
+
+   const uint32_t block_width = getBlockWidth( format );
+   const uint32_t block_height = getBlockHeight( format );
+   const VkDeviceSize blocks_x = (width + block_width - 1) / block_width;
+   const VkDeviceSize blocks_y = (height + block_height - 1) / block_height;
+   return blocks_x * blocks_y * getBlockSize( format );
+}
+
+bool BlockCompressionVK::canDecode(VkFormat format)
+{
+   switch (format) {
+      case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+      case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+      case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+      case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+      case VK_FORMAT_BC3_UNORM_BLOCK:
+      case VK_FORMAT_BC3_SRGB_BLOCK:
+      case VK_FORMAT_BC7_UNORM_BLOCK:
+      case VK_FORMAT_BC7_SRGB_BLOCK:
+         return true;
+      default:
+         return false;
+   }
+}
+
+bool BlockCompressionVK::canEncode(VkFormat format)
+{
+   switch (format) {
+      case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+      case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+      case VK_FORMAT_BC3_UNORM_BLOCK:
+      case VK_FORMAT_BC3_SRGB_BLOCK:
+      case VK_FORMAT_BC7_UNORM_BLOCK:
+      case VK_FORMAT_BC7_SRGB_BLOCK:
+         return true;
+      default:
+         return false;
+   }
+}
+
+void BlockCompressionVK::decode(
+   VkFormat format,
+   const uint8_t* blocks,
+   uint32_t width,
+   uint32_t height,
+   uint8_t* texels
+)
+{
+   if (!canDecode( format )) throw std::runtime_error("failed to decode an unsupported block-compressed format!");
+
+   const uint32_t block_size = getBlockSize( format );
+   const uint32_t blocks_x = (width + 3) / 4;
+   const uint32_t blocks_y = (height + 3) / 4;
+   std::array<uint8_t, 16 * 4> block_texels{};
+   for (uint32_t by = 0; by < blocks_y; ++by) {
+      for (uint32_t bx = 0; bx < blocks_x; ++bx) {
+         const uint8_t* block = blocks + (static_cast<size_t>(by) * blocks_x + bx) * block_size;
+         switch (format) {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+               decodeBC1( block, block_texels.data(), true, false );
+               break;
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+               decodeBC1( block, block_texels.data(), true, true );
+               break;
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+               decodeBC1( block + 8, block_texels.data(), false, false );
+               decodeBC3Alpha( block, block_texels.data() );
+               break;
+            default:
+               decodeBC7( block, block_texels.data() );
+               break;
+         }
+
+         const uint32_t copy_width = std::min( 4u, width - bx * 4 );
+         const uint32_t copy_height = std::min( 4u, height - by * 4 );
+         for (uint32_t y = 0; y < copy_height; ++y) {
+            uint8_t* dst = texels + ((static_cast<size_t>(by) * 4 + y) * width + bx * 4) * 4;
+            std::memcpy( dst, block_texels.data() + y * 16, copy_width * 4 );
+         }
+      }
+   }
+}
+
+void BlockCompressionVK::decodeBC1(
+   const uint8_t* block,
+   uint8_t* texels,
+   bool three_color_mode,
+   bool punch_through_alpha
+)
+{
+   const uint32_t colors[2] = {
+      static_cast<uint32_t>(block[0] | block[1] << 8),
+      static_cast<uint32_t>(block[2] | block[3] << 8)
+   };
+   std::array<std::array<uint8_t, 4>, 4> palette{};
+   for (int i = 0; i < 2; ++i) {
+      const uint32_t r = (colors[i] >> 11) & 31;
+      const uint32_t g = (colors[i] >> 5) & 63;
+      const uint32_t b = colors[i] & 31;
+      palette[i] = {
+         static_cast<uint8_t>(r << 3 | r >> 2),
+         static_cast<uint8_t>(g << 2 | g >> 4),
+         static_cast<uint8_t>(b << 3 | b >> 2),
+         255
+      };
+   }
+   if (!three_color_mode || colors[0] > colors[1]) {
+      for (int c = 0; c < 3; ++c) {
+         palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c]) / 3);
+         palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c]) / 3);
+      }
+      palette[2][3] = palette[3][3] = 255;
+   }
+   else {
+      for (int c = 0; c < 3; ++c) palette[2][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c]) / 2);
+      palette[2][3] = 255;
+      palette[3] = { 0, 0, 0, static_cast<uint8_t>(punch_through_alpha ? 0 : 255) };
+   }
+
+   const uint32_t indices = block[4] | block[5] << 8 | block[6] << 16 | static_cast<uint32_t>(block[7]) << 24;
+   for (uint32_t i = 0; i < 16; ++i) {
+      std::memcpy( texels + i * 4, palette[(indices >> (i * 2)) & 3].data(), 4 );
+   }
+}
+
+void BlockCompressionVK::decodeBC3Alpha(const uint8_t* block, uint8_t* texels)
+{
+   const uint32_t a0 = block[0];
+   const uint32_t a1 = block[1];
+   std::array<uint8_t, 8> palette{ static_cast<uint8_t>(a0), static_cast<uint8_t>(a1) };
+   if (a0 > a1) {
+      for (uint32_t i = 1; i < 7; ++i) palette[i + 1] = static_cast<uint8_t>(((7 - i) * a0 + i * a1) / 7);
+   }
+   else {
+      for (uint32_t i = 1; i < 5; ++i) palette[i + 1] = static_cast<uint8_t>(((5 - i) * a0 + i * a1) / 5);
+      palette[6] = 0;
+      palette[7] = 255;
+   }
+
+   uint64_t indices = 0;
+   for (int i = 0; i < 6; ++i) indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+   for (uint32_t i = 0; i < 16; ++i) texels[i * 4 + 3] = palette[(indices >> (i * 3)) & 7];
+}
+
+uint32_t BlockCompressionVK::getBC7Subset(uint32_t subsets, uint32_t partition, uint32_t texel)
+{
+   if (subsets == 2) return (BC7Partitions2[partition] >> texel) & 1;
+   if (subsets == 3) return BC7Partitions3[partition][texel];
+   return 0;
+}
+
+bool BlockCompressionVK::isBC7Anchor(uint32_t subsets, uint32_t partition, uint32_t texel)
+{
+   if (texel == 0) return true;
+   if (subsets == 2) return texel == BC7Anchors2[partition];
+   if (subsets == 3) return texel == BC7Anchors3[0][partition] || texel == BC7Anchors3[1][partition];
+   return false;
+}
+
+uint32_t BlockCompressionVK::interpolateBC7(uint32_t e0, uint32_t e1, uint32_t index, uint32_t index_bits)
+{
+   static constexpr uint32_t weights2[4] = { 0, 21, 43, 64 };
+   static constexpr uint32_t weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+   static constexpr uint32_t weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+   const uint32_t weight = index_bits == 2 ? weights2[index] : index_bits == 3 ? weights3[index] : weights4[index];
+   return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+void BlockCompressionVK::decodeBC7(const uint8_t* block, uint8_t* texels)
+{
+   BitReader reader( block );
+   uint32_t mode = 0;
+   while (mode < 8 && reader.read( 1 ) == 0) mode++;
+   if (mode == 8) {
+      std::fill( texels, texels + 16 * 4, static_cast<uint8_t>(0) );
+      return;
+   }
+
+   const BC7Mode& info = BC7Modes[mode];
+   const uint32_t partition = reader.read( info.PartitionBits );
+   const uint32_t rotation = reader.read( info.RotationBits );
+   const uint32_t index_selection = reader.read( info.IndexSelectionBits );
+
+   // Endpoint e of subset s is endpoints[s * 2 + e].
+   const uint32_t endpoint_count = info.Subsets * 2;
+   std::array<std::array<uint32_t, 4>, 6> endpoints{};
+   for (uint32_t c = 0; c < 3; ++c) {
+      for (uint32_t e = 0; e < endpoint_count; ++e) endpoints[e][c] = reader.read( info.ColorBits );
+   }
+   for (uint32_t e = 0; e < endpoint_count; ++e) endpoints[e][3] = reader.read( info.AlphaBits );
+
+   uint32_t color_bits = info.ColorBits;
+   uint32_t alpha_bits = info.AlphaBits;
+   if (info.EndpointPBits != 0 || info.SharedPBits != 0) {
+      std::array<uint32_t, 6> p_bits{};
+      if (info.EndpointPBits != 0) {
+         for (uint32_t e = 0; e < endpoint_count; ++e) p_bits[e] = reader.read( 1 );
+      }
+      else {
+         for (uint32_t s = 0; s < info.Subsets; ++s) p_bits[s * 2] = p_bits[s * 2 + 1] = reader.read( 1 );
+      }
+      for (uint32_t e = 0; e < endpoint_count; ++e) {
+         for (uint32_t c = 0; c < (alpha_bits > 0 ? 4u : 3u); ++c) endpoints[e][c] = endpoints[e][c] << 1 | p_bits[e];
+      }
+      color_bits++;
+      if (alpha_bits > 0) alpha_bits++;
+   }
+   for (uint32_t e = 0; e < endpoint_count; ++e) {
+      for (uint32_t c = 0; c < 3; ++c) {
+         endpoints[e][c] = endpoints[e][c] << (8 - color_bits) | endpoints[e][c] >> (2 * color_bits - 8);
+      }
+      if (alpha_bits > 0) {
+         endpoints[e][3] = endpoints[e][3] << (8 - alpha_bits) | endpoints[e][3] >> (2 * alpha_bits - 8);
+      }
+      else endpoints[e][3] = 255;
+   }
+
+   std::array<uint32_t, 16> primary_indices{};
+   std::array<uint32_t, 16> secondary_indices{};
+   for (uint32_t i = 0; i < 16; ++i) {
+      primary_indices[i] = reader.read( info.IndexBits - (isBC7Anchor( info.Subsets, partition, i ) ? 1 : 0) );
+   }
+   if (info.SecondaryIndexBits > 0) {
+      for (uint32_t i = 0; i < 16; ++i) {
+         secondary_indices[i] = reader.read( info.SecondaryIndexBits - (i == 0 ? 1 : 0) );
+      }
+   }
+
+   for (uint32_t i = 0; i < 16; ++i) {
+      const uint32_t subset = getBC7Subset( info.Subsets, partition, i );
+      const auto& e0 = endpoints[subset * 2];
+      const auto& e1 = endpoints[subset * 2 + 1];
+
+      uint32_t color_index = primary_indices[i];
+      uint32_t color_index_bits = info.IndexBits;
+      uint32_t alpha_index = primary_indices[i];
+      uint32_t alpha_index_bits = info.IndexBits;
+      if (info.SecondaryIndexBits > 0) {
+         if (index_selection != 0) {
+            color_index = secondary_indices[i];
+            color_index_bits = info.SecondaryIndexBits;
+         }
+         else {
+            alpha_index = secondary_indices[i];
+            alpha_index_bits = info.SecondaryIndexBits;
+         }
+      }
+
+      std::array<uint8_t, 4> texel{};
+      for (uint32_t c = 0; c < 3; ++c) {
+         texel[c] = static_cast<uint8_t>(interpolateBC7( e0[c], e1[c], color_index, color_index_bits ));
+      }
+      texel[3] = static_cast<uint8_t>(interpolateBC7( e0[3], e1[3], alpha_index, alpha_index_bits ));
+      if (rotation > 0) std::swap( texel[3], texel[rotation - 1] );
+      std::memcpy( texels + i * 4, texel.data(), 4 );
+   }
+}
+
+// Runs inside the jobs of the texture cache's thread pool, which already keeps every core busy with other textures, so
+// one level is encoded on the calling thread.
+void BlockCompressionVK::encode(
+   VkFormat format,
+   const uint8_t* texels,
+   uint32_t width,
+   uint32_t height,
+   uint8_t* blocks
+)
+{
+   if (!canEncode( format )) throw std::runtime_error("failed to encode an unsupported block-compressed format!");
+
+   const uint32_t block_size = getBlockSize( format );
+   const uint32_t blocks_x = (width + 3) / 4;
+   const uint32_t blocks_y = (height + 3) / 4;
+   std::array<uint8_t, 16 * 4> block_texels{};
+   for (uint32_t by = 0; by < blocks_y; ++by) {
+      for (uint32_t bx = 0; bx < blocks_x; ++bx) {
+         uint8_t* block = blocks + (static_cast<size_t>(by) * blocks_x + bx) * block_size;
+         loadBlock( texels, width, height, bx, by, block_texels.data() );
+         switch (format) {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+               encodeBC1( block_texels.data(), block );
+               break;
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+               encodeBC3Alpha( block_texels.data(), block );
+               encodeBC1( block_texels.data(), block + 8 );
+               break;
+            default:
+               encodeBC7( block_texels.data(), block );
+               break;
+         }
+      }
+   }
+}
+
+// Texels outside of the image repeat the last row and column, which keeps them out of the endpoint fit.
+void BlockCompressionVK::loadBlock(
+   const uint8_t* texels,
+   uint32_t width,
+   uint32_t height,
+   uint32_t block_x,
+   uint32_t block_y,
+   uint8_t* block_texels
+)
+{
+   for (uint32_t y = 0; y < 4; ++y) {
+      const uint32_t row = std::min( block_y * 4 + y, height - 1 );
+      for (uint32_t x = 0; x < 4; ++x) {
+         const uint32_t column = std::min( block_x * 4 + x, width - 1 );
+         std::memcpy( block_texels + (y * 4 + x) * 4, texels + (static_cast<size_t>(row) * width + column) * 4, 4 );
+      }
+   }
+}
+
+void BlockCompressionVK::getBounds(const uint8_t* block_texels, uint8_t* min_texel, uint8_t* max_texel)
+{
+#ifdef BLOCK_COMPRESSION_USE_SSE2
+   __m128i low = _mm_loadu_si128( reinterpret_cast<const __m128i*>(block_texels) );
+   __m128i high = low;
+   for (int row = 1; row < 4; ++row) {
+      const __m128i texels = _mm_loadu_si128( reinterpret_cast<const __m128i*>(block_texels + row * 16) );
+      low = _mm_min_epu8( low, texels );
+      high = _mm_max_epu8( high, texels );
+   }
+   low = _mm_min_epu8( low, _mm_srli_si128( low, 8 ) );
+   low = _mm_min_epu8( low, _mm_srli_si128( low, 4 ) );
+   high = _mm_max_epu8( high, _mm_srli_si128( high, 8 ) );
+   high = _mm_max_epu8( high, _mm_srli_si128( high, 4 ) );
+   const int32_t min_bits = _mm_cvtsi128_si32( low );
+   const int32_t max_bits = _mm_cvtsi128_si32( high );
+   std::memcpy( min_texel, &min_bits, 4 );
+   std::memcpy( max_texel, &max_bits, 4 );
+#else
+   std::memcpy( min_texel, block_texels, 4 );
+   std::memcpy( max_texel, block_texels, 4 );
+   for (uint32_t i = 1; i < 16; ++i) {
+      for (uint32_t c = 0; c < 4; ++c) {
+         min_texel[c] = std::min( min_texel[c], block_texels[i * 4 + c] );
+         max_texel[c] = std::max( max_texel[c], block_texels[i * 4 + c] );
+      }
+   }
+#endif
+}
+
+void BlockCompressionVK::encodeBC1(const uint8_t* block_texels, uint8_t* block)
+{
+   std::array<uint8_t, 4> min_texel{};
+   std::array<uint8_t, 4> max_texel{};
+   getBounds( block_texels, min_texel.data(), max_texel.data() );
+
+   // Pulling the endpoints slightly inside the bounding box lowers the average error of the interpolated colors.
+   for (int c = 0; c < 3; ++c) {
+      const auto inset = static_cast<uint8_t>((max_texel[c] - min_texel[c]) >> 4);
+      min_texel[c] = static_cast<uint8_t>(min_texel[c] + inset);
+      max_texel[c] = static_cast<uint8_t>(max_texel[c] - inset);
+   }
+   const auto to565 = [](const std::array<uint8_t, 4>& texel) {
+      return static_cast<uint32_t>((texel[0] >> 3) << 11 | (texel[1] >> 2) << 5 | texel[2] >> 3);
+   };
+
+   // The maximum never packs below the minimum, so different endpoints always select the four-color mode.
+   const uint32_t colors[2] = { to565( max_texel ), to565( min_texel ) };
+   block[0] = static_cast<uint8_t>(colors[0]);
+   block[1] = static_cast<uint8_t>(colors[0] >> 8);
+   block[2] = static_cast<uint8_t>(colors[1]);
+   block[3] = static_cast<uint8_t>(colors[1] >> 8);
+   std::memset( block + 4, 0, 4 );
+   if (colors[0] == colors[1]) return;
+
+   std::array<std::array<int32_t, 3>, 4> palette{};
+   for (int i = 0; i < 2; ++i) {
+      const uint32_t r = (colors[i] >> 11) & 31;
+      const uint32_t g = (colors[i] >> 5) & 63;
+      const uint32_t b = colors[i] & 31;
+      palette[i] = {
+         static_cast<int32_t>(r << 3 | r >> 2),
+         static_cast<int32_t>(g << 2 | g >> 4),
+         static_cast<int32_t>(b << 3 | b >> 2)
+      };
+   }
+   for (int c = 0; c < 3; ++c) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+   }
+
+   uint32_t indices = 0;
+   for (uint32_t i = 0; i < 16; ++i) {
+      uint32_t best_index = 0;
+      int32_t best_error = std::numeric_limits<int32_t>::max();
+      for (uint32_t p = 0; p < 4; ++p) {
+         int32_t error = 0;
+         for (int c = 0; c < 3; ++c) {
+            const int32_t difference = block_texels[i * 4 + c] - palette[p][c];
+            error += difference * difference;
+         }
+         if (error < best_error) {
+            best_error = error;
+            best_index = p;
+         }
+      }
+      indices |= best_index << (i * 2);
+   }
+   for (int i = 0; i < 4; ++i) block[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+}
+
+void BlockCompressionVK::encodeBC3Alpha(const uint8_t* block_texels, uint8_t* block)
+{
+   std::array<uint8_t, 4> min_texel{};
+   std::array<uint8_t, 4> max_texel{};
+   getBounds( block_texels, min_texel.data(), max_texel.data() );
+
+   const uint32_t a0 = max_texel[3];
+   const uint32_t a1 = min_texel[3];
+   block[0] = static_cast<uint8_t>(a0);
+   block[1] = static_cast<uint8_t>(a1);
+   std::memset( block + 2, 0, 6 );
+   if (a0 == a1) return;
+
+   std::array<int32_t, 8> palette{ static_cast<int32_t>(a0), static_cast<int32_t>(a1) };
+   for (uint32_t i = 1; i < 7; ++i) palette[i + 1] = static_cast<int32_t>(((7 - i) * a0 + i * a1) / 7);
+
+   uint64_t indices = 0;
+   for (uint32_t i = 0; i < 16; ++i) {
+      uint64_t best_index = 0;
+      int32_t best_error = std::numeric_limits<int32_t>::max();
+      for (uint32_t p = 0; p < 8; ++p) {
+         const int32_t error = std::abs( block_texels[i * 4 + 3] - palette[p] );
+         if (error < best_error) {
+            best_error = error;
+            best_index = p;
+         }
+      }
+      indices |= best_index << (i * 3);
+   }
+   for (int i = 0; i < 6; ++i) block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+}
+
+// Only mode 6 is used: a single RGBA subset with 7-bit endpoints, unique P-bits and 4-bit indices.
+void BlockCompressionVK::encodeBC7(const uint8_t* block_texels, uint8_t* block)
+{
+   std::array<uint8_t, 4> min_texel{};
+   std::array<uint8_t, 4> max_texel{};
+   getBounds( block_texels, min_texel.data(), max_texel.data() );
+   for (int c = 0; c < 4; ++c) {
+      const auto inset = static_cast<uint8_t>((max_texel[c] - min_texel[c]) >> 4);
+      min_texel[c] = static_cast<uint8_t>(min_texel[c] + inset);
+      max_texel[c] = static_cast<uint8_t>(max_texel[c] - inset);
+   }
+
+   // Each endpoint takes the P-bit that reconstructs its four channels with the smallest error.
+   std::array<std::array<uint32_t, 4>, 2> quantized{};
+   std::array<std::array<int32_t, 4>, 2> endpoints{};
+   std::array<uint32_t, 2> p_bits{};
+   const std::array<const std::array<uint8_t, 4>*, 2> targets = { &min_texel, &max_texel };
+   for (int e = 0; e < 2; ++e) {
+      int32_t best_error = std::numeric_limits<int32_t>::max();
+      for (uint32_t p = 0; p < 2; ++p) {
+         std::array<uint32_t, 4> values{};
+         int32_t error = 0;
+         for (int c = 0; c < 4; ++c) {
+            const auto target = static_cast<int32_t>((*targets[e])[c]);
+            values[c] = static_cast<uint32_t>(std::clamp( (target - static_cast<int32_t>(p) + 1) >> 1, 0, 127 ));
+            const auto reconstructed = static_cast<int32_t>(values[c] << 1 | p);
+            error += (target - reconstructed) * (target - reconstructed);
+         }
+         if (error < best_error) {
+            best_error = error;
+            quantized[e] = values;
+            p_bits[e] = p;
+         }
+      }
+      for (int c = 0; c < 4; ++c) endpoints[e][c] = static_cast<int32_t>(quantized[e][c] << 1 | p_bits[e]);
+   }
+
+   std::array<int32_t, 4> axis{};
+   int32_t axis_length = 0;
+   for (int c = 0; c < 4; ++c) {
+      axis[c] = endpoints[1][c] - endpoints[0][c];
+      axis_length += axis[c] * axis[c];
+   }
+   std::array<uint32_t, 16> indices{};
+   if (axis_length > 0) {
+      for (uint32_t i = 0; i < 16; ++i) {
+         int32_t projection = 0;
+         for (int c = 0; c < 4; ++c) projection += (block_texels[i * 4 + c] - endpoints[0][c]) * axis[c];
+         const int32_t index = (projection * 15 + axis_length / 2) / axis_length;
+         indices[i] = static_cast<uint32_t>(std::clamp( index, 0, 15 ));
+      }
+   }
+
+   // The anchor index drops its top bit, so the endpoints are swapped when the first texel needs it set.
+   if (indices[0] >= 8) {
+      std::swap( quantized[0], quantized[1] );
+      std::swap( p_bits[0], p_bits[1] );
+      for (auto& index : indices) index = 15 - index;
+   }
+
+   std::memset( block, 0, 16 );
+   BitWriter writer( block );
+   writer.write( 1 << 6, 7 );
+   for (int c = 0; c < 4; ++c) {
+      writer.write( quantized[0][c], 7 );
+      writer.write( quantized[1][c], 7 );
+   }
+   writer.write( p_bits[0], 1 );
+   writer.write( p_bits[1], 1 );
+   for (uint32_t i = 0; i < 16; ++i) writer.write( indices[i], i == 0 ? 3 : 4 );
+}
\ No newline at end of file
@@ -40,17 +40,24 @@ CommonVK::QueueFamilyIndices CommonVK::findQueueFamilies(VkPhysicalDevice device
 
    int i = 0;
    for (const auto& queue_family : queue_families) {
-      if (queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT) indices.GraphicsFamily = i;
+      if (!indices.isComplete()) {
+         if (queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT) indices.GraphicsFamily = i;
+
+         VkBool32 present_support = false;
+         vkGetPhysicalDeviceSurfaceSupportKHR(
+            device,
+            i,
+            surface,
+            &present_support
+         );
+         if (present_support) indices.PresentFamily = i;
+      }
 
-      VkBool32 present_support = false;
-      vkGetPhysicalDeviceSurfaceSupportKHR(
-         device,
-         i,
-         surface,
-         &present_support
-      );
-      if (present_support) indices.PresentFamily = i;
-      if (indices.isComplete()) break;
+      // A transfer-only family is usually backed by the copy engines, so it is preferred over a compute family.
+      if ((queue_family.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+         const bool transfer_only = !(queue_family.queueFlags & VK_QUEUE_COMPUTE_BIT);
+         if (!indices.TransferFamily.has_value() || transfer_only) indices.TransferFamily = i;
+      }
       i++;
    }
    return indices;
@@ -81,6 +88,20 @@ bool CommonVK::checkDeviceExtensionSupport(VkPhysicalDevice device)
    return required_extensions.empty();
 }
 
+bool CommonVK::isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extension_name)
+{
+   uint32_t extension_count = 0;
+   vkEnumerateDeviceExtensionProperties( device, nullptr, &extension_count, nullptr );
+   std::vector<VkExtensionProperties> available_extensions( extension_count );
+   vkEnumerateDeviceExtensionProperties( device, nullptr, &extension_count, available_extensions.data() );
+   return std::any_of(
+      available_extensions.begin(), available_extensions.end(),
+      [extension_name](const VkExtensionProperties& extension) {
+         return std::strcmp( extension.extensionName, extension_name ) == 0;
+      }
+   );
+}
+
 CommonVK::SwapChainSupportDetails CommonVK::querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface)
 {
    SwapChainSupportDetails details;
@@ -131,6 +152,11 @@ bool CommonVK::isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface)
    QueueFamilyIndices indices = findQueueFamilies( device, surface );
    if (!indices.isComplete()) return false;
 
+   // The Vulkan 1.2 feature struct below is only valid in the chain of a device that supports 1.2.
+   VkPhysicalDeviceProperties properties;
+   vkGetPhysicalDeviceProperties( device, &properties );
+   if (properties.apiVersion < VK_API_VERSION_1_2) return false;
+
    bool swap_chain_adequate = false;
    bool extensions_supported = checkDeviceExtensionSupport( device );
    if (extensions_supported) {
@@ -138,9 +164,14 @@ bool CommonVK::isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface)
       swap_chain_adequate = !swap_chain_support.Formats.empty() && !swap_chain_support.PresentModes.empty();
    }
 
-   VkPhysicalDeviceFeatures supported_features;
-   vkGetPhysicalDeviceFeatures( device, &supported_features );
-   return extensions_supported && swap_chain_adequate && supported_features.samplerAnisotropy;
+   VkPhysicalDeviceVulkan12Features supported_vulkan12_features{};
+   supported_vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+   VkPhysicalDeviceFeatures2 supported_features{};
+   supported_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+   supported_features.pNext = &supported_vulkan12_features;
+   vkGetPhysicalDeviceFeatures2( device, &supported_features );
+   return extensions_supported && swap_chain_adequate && supported_features.features.samplerAnisotropy &&
+      supported_vulkan12_features.timelineSemaphore;
 }
 
 void CommonVK::pickPhysicalDevice(VkInstance instance, VkSurfaceKHR surface)
@@ -163,6 +194,37 @@ void CommonVK::pickPhysicalDevice(VkInstance instance, VkSurfaceKHR surface)
       }
    }
    if (PhysicalDevice == VK_NULL_HANDLE) throw std::runtime_error("failed to find a suitable GPU!");
+
+   vkGetPhysicalDeviceProperties( PhysicalDevice, &PhysicalDeviceProperties );
+   UnifiedMemory = checkUnifiedMemory( PhysicalDevice );
+}
+
+// Integrated GPUs and software implementations share one memory with the host, which shows up either as the device
+// type or as every heap being device-local. Buffers can then be written in place instead of going through staging, as
+// long as one of the device-local memory types is also coherently mappable.
+bool CommonVK::checkUnifiedMemory(VkPhysicalDevice device)
+{
+   VkPhysicalDeviceProperties properties;
+   vkGetPhysicalDeviceProperties( device, &properties );
+   VkPhysicalDeviceMemoryProperties memory_properties;
+   vkGetPhysicalDeviceMemoryProperties( device, &memory_properties );
+
+   bool shared_heaps = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ||
+      properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+   if (!shared_heaps) {
+      shared_heaps = true;
+      for (uint32_t i = 0; i < memory_properties.memoryHeapCount; ++i) {
+         if ((memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) == 0) shared_heaps = false;
+      }
+   }
+   if (!shared_heaps) return false;
+
+   constexpr VkMemoryPropertyFlags required_properties =
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+   for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i) {
+      if ((memory_properties.memoryTypes[i].propertyFlags & required_properties) == required_properties) return true;
+   }
+   return false;
 }
 
 void CommonVK::createLogicalDevice(VkSurfaceKHR surface)
@@ -171,6 +233,7 @@ void CommonVK::createLogicalDevice(VkSurfaceKHR surface)
    std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
    QueueFamilyIndices indices = findQueueFamilies( PhysicalDevice, surface );
    std::set<uint32_t> unique_queue_families = { indices.GraphicsFamily.value(), indices.PresentFamily.value() };
+   if (indices.TransferFamily.has_value()) unique_queue_families.insert( indices.TransferFamily.value() );
    for (uint32_t queue_family : unique_queue_families) {
       VkDeviceQueueCreateInfo queue_create_info{};
       queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
@@ -183,13 +246,23 @@ void CommonVK::createLogicalDevice(VkSurfaceKHR surface)
    VkPhysicalDeviceFeatures device_features{};
    // write later ...
 
+   VkPhysicalDeviceVulkan12Features vulkan12_features{};
+   vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+   vulkan12_features.timelineSemaphore = VK_TRUE;
+
+   // VK_EXT_memory_budget is optional; without it, the allocator estimates budgets from its own allocations.
+   std::vector<const char*> extensions( DeviceExtensions.begin(), DeviceExtensions.end() );
+   MemoryBudgetSupported = isDeviceExtensionAvailable( PhysicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME );
+   if (MemoryBudgetSupported) extensions.emplace_back( VK_EXT_MEMORY_BUDGET_EXTENSION_NAME );
+
    VkDeviceCreateInfo create_info{};
    create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+   create_info.pNext = &vulkan12_features;
    create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
    create_info.pQueueCreateInfos = queue_create_infos.data();
    create_info.pEnabledFeatures = &device_features;
-   create_info.enabledExtensionCount = static_cast<uint32_t>(DeviceExtensions.size());
-   create_info.ppEnabledExtensionNames = DeviceExtensions.data();
+   create_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+   create_info.ppEnabledExtensionNames = extensions.data();
 
 #ifdef NDBUG
    create_info.enabledLayerCount = 0;
@@ -221,6 +294,15 @@ void CommonVK::createLogicalDevice(VkSurfaceKHR surface)
       0,
       &PresentQueue
    );
+
+   GraphicsQueueFamily = indices.GraphicsFamily.value();
+   TransferQueueFamily = indices.TransferFamily.value_or( GraphicsQueueFamily );
+   vkGetDeviceQueue(
+      Device,
+      TransferQueueFamily,
+      0,
+      &TransferQueue
+   );
 }
 
 void CommonVK::createCommandPool(VkSurfaceKHR surface)
@@ -248,15 +330,21 @@ VkFormat CommonVK::findSupportedFormat(
 )
 {
    for (VkFormat format : candidates) {
-      VkFormatProperties props;
-      vkGetPhysicalDeviceFormatProperties( PhysicalDevice, format, &props );
-
-      if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features) return format;
-      if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features) return format;
+      if (isFormatSupported( format, tiling, features )) return format;
    }
    throw std::runtime_error("failed to find supported format!");
 }
 
+bool CommonVK::isFormatSupported(VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features)
+{
+   VkFormatProperties props;
+   vkGetPhysicalDeviceFormatProperties( PhysicalDevice, format, &props );
+
+   if (tiling == VK_IMAGE_TILING_LINEAR) return (props.linearTilingFeatures & features) == features;
+   if (tiling == VK_IMAGE_TILING_OPTIMAL) return (props.optimalTilingFeatures & features) == features;
+   return false;
+}
+
 VkFormat CommonVK::findDepthFormat()
 {
    return findSupportedFormat(
@@ -266,24 +354,146 @@ VkFormat CommonVK::findDepthFormat()
    );
 }
 
-uint32_t CommonVK::findMemoryType(uint32_t type_filter, VkMemoryPropertyFlags properties)
+void CommonVK::createAllocator()
 {
-   VkPhysicalDeviceMemoryProperties memory_properties;
-   vkGetPhysicalDeviceMemoryProperties( PhysicalDevice, &memory_properties );
-   for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i) {
-      if ((type_filter & (1 << i)) && (memory_properties.memoryTypes[i].propertyFlags & properties) == properties) {
-          return i;
-      }
+   Allocator = std::make_unique<MemoryAllocatorVK>( PhysicalDevice, Device, MemoryBudgetSupported );
+#ifdef BENCHMARK_MEMORY_TYPES
+   Allocator->benchmarkMemoryTypes( std::cout );
+#endif
+}
+
+void CommonVK::destroyAllocator()
+{
+#ifdef _DEBUG
+   Allocator->printStatistics( std::cout );
+#endif
+   Allocator.reset();
+}
+
+std::vector<uint8_t> CommonVK::readPipelineCacheFile(const std::string& file_path)
+{
+   std::ifstream file( file_path, std::ios::binary | std::ios::ate );
+   if (!file.is_open()) return {};
+
+   const auto file_size = static_cast<size_t>(file.tellg());
+   if (file_size < sizeof( PipelineCacheFileHeader ) + sizeof( VkPipelineCacheHeaderVersionOne )) return {};
+   file.seekg( 0 );
+   PipelineCacheFileHeader file_header{};
+   file.read( reinterpret_cast<char*>(&file_header), sizeof( file_header ) );
+   if (file_header.Magic != PipelineCacheMagic ||
+       file_header.DriverVersion != PhysicalDeviceProperties.driverVersion ||
+       file_header.DataSize != file_size - sizeof( PipelineCacheFileHeader )) return {};
+
+   std::vector<uint8_t> data(file_header.DataSize);
+   file.read( reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()) );
+   if (!file.good() || getFNVHash( data.data(), data.size() ) != file_header.Checksum) return {};
+
+   VkPipelineCacheHeaderVersionOne cache_header{};
+   std::memcpy( &cache_header, data.data(), sizeof( cache_header ) );
+   if (cache_header.headerSize < sizeof( cache_header ) ||
+       cache_header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+       cache_header.vendorID != PhysicalDeviceProperties.vendorID ||
+       cache_header.deviceID != PhysicalDeviceProperties.deviceID ||
+       std::memcmp( cache_header.pipelineCacheUUID, PhysicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE ) != 0) {
+      return {};
    }
-   throw std::runtime_error("failed to find suitable memory type!");
+   return data;
+}
+
+void CommonVK::writePipelineCacheFile(const std::string& file_path)
+{
+   size_t data_size = 0;
+   if (vkGetPipelineCacheData( Device, PipelineCache, &data_size, nullptr ) != VK_SUCCESS || data_size == 0) return;
+   std::vector<uint8_t> data(data_size);
+   if (vkGetPipelineCacheData( Device, PipelineCache, &data_size, data.data() ) != VK_SUCCESS) {
+      throw std::runtime_error("failed to get pipeline cache data!");
+   }
+   data.resize( data_size );
+
+   PipelineCacheFileHeader file_header{};
+   file_header.Magic = PipelineCacheMagic;
+   file_header.DriverVersion = PhysicalDeviceProperties.driverVersion;
+   file_header.DataSize = data.size();
+   file_header.Checksum = getFNVHash( data.data(), data.size() );
+
+   // Written next to the destination and renamed over it, so an interrupted write never leaves a broken cache behind,
+   // and other instances of the application that save the same cache never write into the same temporary file.
+   std::filesystem::create_directories( std::filesystem::path(file_path).parent_path() );
+   const std::string temporary_path = getTemporaryPath( file_path );
+   {
+      std::ofstream file( temporary_path, std::ios::binary | std::ios::trunc );
+      if (!file.is_open()) throw std::runtime_error("failed to create pipeline cache file!");
+      file.write( reinterpret_cast<const char*>(&file_header), sizeof( file_header ) );
+      file.write( reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()) );
+      if (!file.good()) throw std::runtime_error("failed to write pipeline cache file!");
+   }
+   std::filesystem::rename( temporary_path, file_path );
+}
+
+void CommonVK::createPipelineCache(const std::string& file_path)
+{
+   PipelineCacheFilePath = file_path;
+   const std::vector<uint8_t> initial_data = readPipelineCacheFile( file_path );
+
+   VkPipelineCacheCreateInfo cache_info{};
+   cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+   cache_info.initialDataSize = initial_data.size();
+   cache_info.pInitialData = initial_data.empty() ? nullptr : initial_data.data();
+   VkResult result = vkCreatePipelineCache( Device, &cache_info, nullptr, &PipelineCache );
+   PipelineCacheWarm = result == VK_SUCCESS && !initial_data.empty();
+   if (result != VK_SUCCESS && !initial_data.empty()) {
+      cache_info.initialDataSize = 0;
+      cache_info.pInitialData = nullptr;
+      result = vkCreatePipelineCache( Device, &cache_info, nullptr, &PipelineCache );
+   }
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to create pipeline cache!");
+}
+
+void CommonVK::destroyPipelineCache()
+{
+   // The file only saves work on the next run, so failing to write it is not fatal.
+   try {
+      writePipelineCacheFile( PipelineCacheFilePath );
+   }
+   catch (const std::exception& exception) {
+      std::cerr << "pipeline cache: " << exception.what() << " (" << PipelineCacheFilePath << ")\n";
+   }
+   vkDestroyPipelineCache( Device, PipelineCache, nullptr );
+   PipelineCache = VK_NULL_HANDLE;
+}
+
+void CommonVK::createPipelineRegistry()
+{
+   PipelineRegistry = std::make_unique<PipelineRegistryVK>( Device, PipelineCache );
+}
+
+void CommonVK::destroyPipelineRegistry()
+{
+#ifdef _DEBUG
+   PipelineRegistry->printStatistics( std::cout );
+#endif
+   PipelineRegistry.reset();
+}
+
+void CommonVK::createDescriptorAllocator()
+{
+   DescriptorAllocator = std::make_unique<DescriptorAllocatorVK>( Device, static_cast<uint32_t>(MaxFramesInFlight) );
+}
+
+void CommonVK::destroyDescriptorAllocator()
+{
+#ifdef _DEBUG
+   std::cout << "descriptor pools: " << DescriptorAllocator->getPoolCount() << "\n";
+#endif
+   DescriptorAllocator.reset();
 }
 
 void CommonVK::createBuffer(
    VkDeviceSize size,
    VkBufferUsageFlags usage,
-   VkMemoryPropertyFlags properties,
+   MemoryAllocatorVK::Usage memory_usage,
    VkBuffer& buffer,
-   VkDeviceMemory& buffer_memory
+   MemoryAllocatorVK::Allocation& buffer_memory
 )
 {
    VkBufferCreateInfo buffer_info{};
@@ -299,20 +509,21 @@ void CommonVK::createBuffer(
    VkMemoryRequirements memory_requirements;
    vkGetBufferMemoryRequirements( Device, buffer, &memory_requirements );
 
-   VkMemoryAllocateInfo allocate_info{};
-   allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-   allocate_info.allocationSize = memory_requirements.size;
-   allocate_info.memoryTypeIndex = findMemoryType( memory_requirements.memoryTypeBits, properties );
-
-   result = vkAllocateMemory(
-      Device,
-      &allocate_info,
-      nullptr,
-      &buffer_memory
+   buffer_memory = Allocator->allocate(
+      memory_requirements,
+      findMemoryType( memory_requirements.memoryTypeBits, memory_usage ),
+      true
    );
-   if (result != VK_SUCCESS) throw std::runtime_error("failed to allocate buffer memory!");
 
-   vkBindBufferMemory( Device, buffer, buffer_memory, 0 );
+   result = vkBindBufferMemory( Device, buffer, buffer_memory.Memory, buffer_memory.Offset );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to bind buffer memory!");
+}
+
+void CommonVK::destroyBuffer(VkBuffer& buffer, MemoryAllocatorVK::Allocation& buffer_memory)
+{
+   vkDestroyBuffer( Device, buffer, nullptr );
+   Allocator->free( buffer_memory );
+   buffer = VK_NULL_HANDLE;
 }
 
 void CommonVK::createImage(
@@ -321,9 +532,11 @@ void CommonVK::createImage(
    VkFormat format,
    VkImageTiling tiling,
    VkImageUsageFlags usage,
-   VkMemoryPropertyFlags properties,
+   MemoryAllocatorVK::Usage memory_usage,
    VkImage& image,
-   VkDeviceMemory& image_memory
+   MemoryAllocatorVK::Allocation& image_memory,
+   uint32_t mip_levels,
+   uint32_t array_layers
 )
 {
    VkImageCreateInfo image_info{};
@@ -332,8 +545,8 @@ void CommonVK::createImage(
    image_info.extent.width = width;
    image_info.extent.height = height;
    image_info.extent.depth = 1;
-   image_info.mipLevels = 1;
-   image_info.arrayLayers = 1;
+   image_info.mipLevels = mip_levels;
+   image_info.arrayLayers = array_layers;
    image_info.format = format;
    image_info.tiling = tiling;
    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -347,34 +560,43 @@ void CommonVK::createImage(
    VkMemoryRequirements memory_requirements;
    vkGetImageMemoryRequirements( Device, image, &memory_requirements);
 
-   VkMemoryAllocateInfo allocate_info{};
-   allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-   allocate_info.allocationSize = memory_requirements.size;
-   allocate_info.memoryTypeIndex = findMemoryType( memory_requirements.memoryTypeBits, properties );
-
-   result = vkAllocateMemory(
-      Device,
-      &allocate_info,
-      nullptr,
-      &image_memory
+   image_memory = Allocator->allocate(
+      memory_requirements,
+      findMemoryType( memory_requirements.memoryTypeBits, memory_usage ),
+      tiling == VK_IMAGE_TILING_LINEAR
    );
-   if (result != VK_SUCCESS) throw std::runtime_error("failed to allocate image memory!");
 
-   vkBindImageMemory( Device, image, image_memory, 0 );
+   result = vkBindImageMemory( Device, image, image_memory.Memory, image_memory.Offset );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to bind image memory!");
+}
+
+void CommonVK::destroyImage(VkImage& image, MemoryAllocatorVK::Allocation& image_memory)
+{
+   vkDestroyImage( Device, image, nullptr );
+   Allocator->free( image_memory );
+   image = VK_NULL_HANDLE;
 }
 
-VkImageView CommonVK::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect_flags)
+VkImageView CommonVK::createImageView(
+   VkImage image,
+   VkFormat format,
+   VkImageAspectFlags aspect_flags,
+   uint32_t mip_levels,
+   uint32_t layer_count,
+   const VkComponentMapping& components
+)
 {
    VkImageViewCreateInfo view_info{};
    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
    view_info.image = image;
-   view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+   view_info.viewType = layer_count > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
    view_info.format = format;
+   view_info.components = components;
    view_info.subresourceRange.aspectMask = aspect_flags;
    view_info.subresourceRange.baseMipLevel = 0;
-   view_info.subresourceRange.levelCount = 1;
+   view_info.subresourceRange.levelCount = mip_levels;
    view_info.subresourceRange.baseArrayLayer = 0;
-   view_info.subresourceRange.layerCount = 1;
+   view_info.subresourceRange.layerCount = layer_count;
 
    VkImageView image_view;
    const VkResult result = vkCreateImageView(
@@ -387,6 +609,171 @@ VkImageView CommonVK::createImageView(VkImage image, VkFormat format, VkImageAsp
    return image_view;
 }
 
+uint32_t CommonVK::getMipLevelCount(uint32_t width, uint32_t height)
+{
+   uint32_t mip_levels = 1;
+   for (uint32_t size = std::max( width, height ); size > 1; size /= 2) mip_levels++;
+   return mip_levels;
+}
+
+bool CommonVK::supportsLinearBlit(VkFormat format)
+{
+   VkFormatProperties format_properties;
+   vkGetPhysicalDeviceFormatProperties( PhysicalDevice, format, &format_properties );
+   const VkFormatFeatureFlags required_features =
+      VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+      VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+   return (format_properties.optimalTilingFeatures & required_features) == required_features;
+}
+
+// Expects every level in TRANSFER_DST_OPTIMAL with level 0 written, and leaves all of them in SHADER_READ_ONLY_OPTIMAL.
+// The command buffer has to belong to a graphics queue because of vkCmdBlitImage.
+void CommonVK::generateMipmaps(
+   VkCommandBuffer command_buffer,
+   VkImage image,
+   uint32_t width,
+   uint32_t height,
+   uint32_t mip_levels
+)
+{
+   VkImageSubresourceRange subresource_range{};
+   subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+   subresource_range.levelCount = 1;
+   subresource_range.baseArrayLayer = 0;
+   subresource_range.layerCount = 1;
+
+   auto src_width = static_cast<int32_t>(width);
+   auto src_height = static_cast<int32_t>(height);
+   for (uint32_t level = 1; level < mip_levels; ++level) {
+      subresource_range.baseMipLevel = level - 1;
+      insertImageMemoryBarrier(
+         command_buffer,
+         image,
+         VK_ACCESS_TRANSFER_WRITE_BIT,
+         VK_ACCESS_TRANSFER_READ_BIT,
+         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+         VK_PIPELINE_STAGE_TRANSFER_BIT,
+         VK_PIPELINE_STAGE_TRANSFER_BIT,
+         subresource_range
+      );
+
+      const int32_t dst_width = std::max( src_width / 2, 1 );
+      const int32_t dst_height = std::max( src_height / 2, 1 );
+      VkImageBlit blit{};
+      blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      blit.srcSubresource.mipLevel = level - 1;
+      blit.srcSubresource.baseArrayLayer = 0;
+      blit.srcSubresource.layerCount = 1;
+      blit.srcOffsets[0] = { 0, 0, 0 };
+      blit.srcOffsets[1] = { src_width, src_height, 1 };
+      blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      blit.dstSubresource.mipLevel = level;
+      blit.dstSubresource.baseArrayLayer = 0;
+      blit.dstSubresource.layerCount = 1;
+      blit.dstOffsets[0] = { 0, 0, 0 };
+      blit.dstOffsets[1] = { dst_width, dst_height, 1 };
+      vkCmdBlitImage(
+         command_buffer,
+         image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+         image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+         1, &blit,
+         VK_FILTER_LINEAR
+      );
+
+      insertImageMemoryBarrier(
+         command_buffer,
+         image,
+         VK_ACCESS_TRANSFER_READ_BIT,
+         VK_ACCESS_SHADER_READ_BIT,
+         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+         VK_PIPELINE_STAGE_TRANSFER_BIT,
+         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+         subresource_range
+      );
+      src_width = dst_width;
+      src_height = dst_height;
+   }
+
+   subresource_range.baseMipLevel = mip_levels - 1;
+   insertImageMemoryBarrier(
+      command_buffer,
+      image,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_ACCESS_SHADER_READ_BIT,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      subresource_range
+   );
+}
+
+VkSampler CommonVK::getSampler(const VkSamplerCreateInfo& sampler_info)
+{
+   if (sampler_info.pNext != nullptr) throw std::runtime_error("failed to cache a sampler with an extension chain!");
+
+   const auto bits = [](float value) {
+      uint32_t result;
+      std::memcpy( &result, &value, sizeof( result ) );
+      return result;
+   };
+   const SamplerKey key = {
+      sampler_info.flags,
+      static_cast<uint32_t>(sampler_info.magFilter),
+      static_cast<uint32_t>(sampler_info.minFilter),
+      static_cast<uint32_t>(sampler_info.mipmapMode),
+      static_cast<uint32_t>(sampler_info.addressModeU),
+      static_cast<uint32_t>(sampler_info.addressModeV),
+      static_cast<uint32_t>(sampler_info.addressModeW),
+      bits( sampler_info.mipLodBias ),
+      sampler_info.anisotropyEnable,
+      bits( sampler_info.maxAnisotropy ),
+      sampler_info.compareEnable,
+      static_cast<uint32_t>(sampler_info.compareOp),
+      bits( sampler_info.minLod ),
+      bits( sampler_info.maxLod ),
+      static_cast<uint32_t>(sampler_info.borderColor),
+      sampler_info.unnormalizedCoordinates
+   };
+
+   std::lock_guard<std::mutex> lock( SamplerMutex );
+   const auto it = Samplers.find( key );
+   if (it != Samplers.end()) return it->second;
+
+   VkSampler sampler;
+   const VkResult result = vkCreateSampler( Device, &sampler_info, nullptr, &sampler );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to create texture sampler!");
+   Samplers.emplace( key, sampler );
+   return sampler;
+}
+
+void CommonVK::destroySamplers()
+{
+   std::lock_guard<std::mutex> lock( SamplerMutex );
+   for (const auto& sampler : Samplers) vkDestroySampler( Device, sampler.second, nullptr );
+   Samplers.clear();
+}
+
+VkResult CommonVK::submitToQueue(VkQueue queue, const VkSubmitInfo& submit_info, VkFence fence)
+{
+   std::lock_guard<std::mutex> lock( QueueMutex );
+   return vkQueueSubmit( queue, 1, &submit_info, fence );
+}
+
+VkResult CommonVK::presentToQueue(const VkPresentInfoKHR& present_info)
+{
+   std::lock_guard<std::mutex> lock( QueueMutex );
+   return vkQueuePresentKHR( PresentQueue, &present_info );
+}
+
+void CommonVK::waitDeviceIdle()
+{
+   std::lock_guard<std::mutex> lock( QueueMutex );
+   vkDeviceWaitIdle( Device );
+}
+
 VkCommandBuffer CommonVK::createCommandBuffer(VkCommandBufferLevel level)
 {
    VkCommandBufferAllocateInfo command_buffer_allocate_info {};
@@ -425,7 +812,7 @@ void CommonVK::flushCommandBuffer(VkCommandBuffer command_buffer)
 
    VkFence fence;
    vkCreateFence( Device, &fence_create_info, nullptr, &fence );
-   vkQueueSubmit( GraphicsQueue, 1, &submitInfo, fence );
+   submitToQueue( GraphicsQueue, submitInfo, fence );
    vkWaitForFences( Device, 1, &fence, VK_TRUE, UINT64_MAX );
    vkDestroyFence( Device, fence, nullptr );
    vkFreeCommandBuffers(
@@ -0,0 +1,301 @@
+#include "defragmenter.h"
+
+DefragmenterVK::DefragmenterVK(VkDeviceSize max_bytes_per_step, uint32_t max_moves_per_step) :
+   MaxBytesPerStep( max_bytes_per_step ), MaxMovesPerStep( max_moves_per_step ), BytesReclaimed( 0 ), NextId( 1 )
+{
+}
+
+DefragmenterVK::~DefragmenterVK()
+{
+   for (auto& move : PendingMoves) destroy( move );
+}
+
+uint64_t DefragmenterVK::registerBuffer(
+   VkBuffer& buffer,
+   MemoryAllocatorVK::Allocation& memory,
+   VkDeviceSize size,
+   VkBufferUsageFlags usage,
+   uint64_t upload_ticket,
+   MovedCallback on_moved
+)
+{
+   Resource resource;
+   resource.Buffer = &buffer;
+   resource.Memory = &memory;
+   resource.BufferSize = size;
+   resource.BufferUsage = usage;
+   resource.UploadTicket = upload_ticket;
+   resource.OnMoved = std::move( on_moved );
+
+   std::lock_guard<std::mutex> lock( Mutex );
+   const uint64_t id = NextId++;
+   Resources.emplace( id, std::move( resource ) );
+   return id;
+}
+
+uint64_t DefragmenterVK::registerImage(
+   VkImage& image,
+   MemoryAllocatorVK::Allocation& memory,
+   uint32_t width,
+   uint32_t height,
+   VkFormat format,
+   VkImageUsageFlags usage,
+   uint32_t mip_levels,
+   uint64_t upload_ticket,
+   MovedCallback on_moved
+)
+{
+   Resource resource;
+   resource.Image = &image;
+   resource.Memory = &memory;
+   resource.Width = width;
+   resource.Height = height;
+   resource.Format = format;
+   resource.ImageUsage = usage;
+   resource.MipLevels = mip_levels;
+   resource.UploadTicket = upload_ticket;
+   resource.OnMoved = std::move( on_moved );
+
+   std::lock_guard<std::mutex> lock( Mutex );
+   const uint64_t id = NextId++;
+   Resources.emplace( id, std::move( resource ) );
+   return id;
+}
+
+void DefragmenterVK::unregister(uint64_t id)
+{
+   // A pending move of this resource is dropped in completeMoves(), which then only hands over the copy to destroy.
+   std::lock_guard<std::mutex> lock( Mutex );
+   Resources.erase( id );
+}
+
+VkDeviceSize DefragmenterVK::getBytesReclaimed() const
+{
+   std::lock_guard<std::mutex> lock( Mutex );
+   return BytesReclaimed;
+}
+
+bool DefragmenterVK::createBuffer(const Resource& resource, Move& move)
+{
+   VkBufferCreateInfo buffer_info{};
+   buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+   buffer_info.size = resource.BufferSize;
+   buffer_info.usage = resource.BufferUsage;
+   buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+   if (vkCreateBuffer( CommonVK::getDevice(), &buffer_info, nullptr, &move.Buffer ) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create buffer!");
+   }
+
+   VkMemoryRequirements memory_requirements;
+   vkGetBufferMemoryRequirements( CommonVK::getDevice(), move.Buffer, &memory_requirements );
+   move.Memory = CommonVK::getAllocator()->allocateForMove( memory_requirements, *resource.Memory );
+   if (!move.Memory.isValid()) {
+      vkDestroyBuffer( CommonVK::getDevice(), move.Buffer, nullptr );
+      move.Buffer = VK_NULL_HANDLE;
+      return false;
+   }
+
+   const VkResult result =
+      vkBindBufferMemory( CommonVK::getDevice(), move.Buffer, move.Memory.Memory, move.Memory.Offset );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to bind buffer memory!");
+   return true;
+}
+
+bool DefragmenterVK::createImage(const Resource& resource, Move& move)
+{
+   VkImageCreateInfo image_info{};
+   image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+   image_info.imageType = VK_IMAGE_TYPE_2D;
+   image_info.extent.width = resource.Width;
+   image_info.extent.height = resource.Height;
+   image_info.extent.depth = 1;
+   image_info.mipLevels = resource.MipLevels;
+   image_info.arrayLayers = 1;
+   image_info.format = resource.Format;
+   image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+   image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+   image_info.usage = resource.ImageUsage;
+   image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+   image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+   if (vkCreateImage( CommonVK::getDevice(), &image_info, nullptr, &move.Image ) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create image!");
+   }
+
+   VkMemoryRequirements memory_requirements;
+   vkGetImageMemoryRequirements( CommonVK::getDevice(), move.Image, &memory_requirements );
+   move.Memory = CommonVK::getAllocator()->allocateForMove( memory_requirements, *resource.Memory );
+   if (!move.Memory.isValid()) {
+      vkDestroyImage( CommonVK::getDevice(), move.Image, nullptr );
+      move.Image = VK_NULL_HANDLE;
+      return false;
+   }
+
+   const VkResult result =
+      vkBindImageMemory( CommonVK::getDevice(), move.Image, move.Memory.Memory, move.Memory.Offset );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to bind image memory!");
+   return true;
+}
+
+void DefragmenterVK::recordBufferCopy(VkCommandBuffer command_buffer, const Resource& resource, const Move& move)
+{
+   VkBufferCopy copy_region{};
+   copy_region.size = resource.BufferSize;
+   vkCmdCopyBuffer( command_buffer, *resource.Buffer, move.Buffer, 1, &copy_region );
+}
+
+void DefragmenterVK::recordImageCopy(VkCommandBuffer command_buffer, const Resource& resource, const Move& move)
+{
+   const VkImageSubresourceRange subresource_range{ VK_IMAGE_ASPECT_COLOR_BIT, 0, resource.MipLevels, 0, 1 };
+   CommonVK::insertImageMemoryBarrier(
+      command_buffer, *resource.Image,
+      VK_ACCESS_MEMORY_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+      subresource_range
+   );
+   CommonVK::insertImageMemoryBarrier(
+      command_buffer, move.Image,
+      0, VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+      subresource_range
+   );
+
+   std::vector<VkImageCopy> copy_regions(resource.MipLevels);
+   for (uint32_t level = 0; level < resource.MipLevels; ++level) {
+      VkImageCopy& region = copy_regions[level];
+      region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+      region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+      region.extent.width = std::max( resource.Width >> level, 1u );
+      region.extent.height = std::max( resource.Height >> level, 1u );
+      region.extent.depth = 1;
+   }
+   vkCmdCopyImage(
+      command_buffer,
+      *resource.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      move.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      static_cast<uint32_t>(copy_regions.size()), copy_regions.data()
+   );
+
+   CommonVK::insertImageMemoryBarrier(
+      command_buffer, *resource.Image,
+      VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+      VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      subresource_range
+   );
+   CommonVK::insertImageMemoryBarrier(
+      command_buffer, move.Image,
+      VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+      VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      subresource_range
+   );
+}
+
+uint32_t DefragmenterVK::recordMoves(VkCommandBuffer command_buffer, uint64_t acquired_upload_value)
+{
+   std::lock_guard<std::mutex> lock( Mutex );
+   if (!PendingMoves.empty()) return 0;
+
+   // Dedicated allocations own their memory outright, so moving them never frees a block.
+   MemoryAllocatorVK* allocator = CommonVK::getAllocator();
+   std::vector<std::pair<float, uint64_t>> candidates;
+   for (const auto& [id, resource] : Resources) {
+      if (resource.UploadTicket > acquired_upload_value || resource.Memory->Dedicated) continue;
+      const float occupancy = allocator->getBlockOccupancy( *resource.Memory );
+      if (occupancy < MaxSourceOccupancy) candidates.emplace_back( occupancy, id );
+   }
+   if (candidates.empty()) return 0;
+   std::sort( candidates.begin(), candidates.end() );
+
+   // The uploads of these resources were made visible to the stages that use them, not to transfers.
+   VkMemoryBarrier read_barrier{};
+   read_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+   read_barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+   read_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+   vkCmdPipelineBarrier(
+      command_buffer,
+      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+      1, &read_barrier, 0, nullptr, 0, nullptr
+   );
+
+   VkDeviceSize bytes = 0;
+   bool buffers_copied = false;
+   for (const auto& candidate : candidates) {
+      if (PendingMoves.size() >= MaxMovesPerStep) break;
+      const Resource& resource = Resources.at( candidate.second );
+      if (bytes + resource.Memory->Size > MaxBytesPerStep) continue;
+
+      Move move{};
+      move.ResourceId = candidate.second;
+      if (resource.Buffer != nullptr) {
+         if (!createBuffer( resource, move )) continue;
+         recordBufferCopy( command_buffer, resource, move );
+         buffers_copied = true;
+      }
+      else {
+         if (!createImage( resource, move )) continue;
+         recordImageCopy( command_buffer, resource, move );
+      }
+      bytes += resource.Memory->Size;
+      PendingMoves.emplace_back( move );
+   }
+
+   // Pipeline barriers reach later submissions too, so this also covers the frames that use the new buffers.
+   if (buffers_copied) {
+      VkMemoryBarrier write_barrier{};
+      write_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      write_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      write_barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+      vkCmdPipelineBarrier(
+         command_buffer,
+         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+         1, &write_barrier, 0, nullptr, 0, nullptr
+      );
+   }
+   return static_cast<uint32_t>(PendingMoves.size());
+}
+
+void DefragmenterVK::destroy(Move& move)
+{
+   if (move.Buffer != VK_NULL_HANDLE) CommonVK::destroyBuffer( move.Buffer, move.Memory );
+   if (move.Image != VK_NULL_HANDLE) CommonVK::destroyImage( move.Image, move.Memory );
+}
+
+void DefragmenterVK::release(Move& move)
+{
+   std::lock_guard<std::mutex> lock( Mutex );
+   MemoryAllocatorVK* allocator = CommonVK::getAllocator();
+   const VkDeviceSize block_bytes = allocator->getStatistics().BlockBytes;
+   destroy( move );
+   const VkDeviceSize remaining_block_bytes = allocator->getStatistics().BlockBytes;
+   if (remaining_block_bytes < block_bytes) BytesReclaimed += block_bytes - remaining_block_bytes;
+}
+
+uint32_t DefragmenterVK::completeMoves(const DeferDestruction& defer_destruction)
+{
+   std::vector<MovedCallback> callbacks;
+   {
+      std::lock_guard<std::mutex> lock( Mutex );
+      if (PendingMoves.empty()) return 0;
+
+      for (auto& move : PendingMoves) {
+         // Swapping hands the old handle and allocation to the move. A move whose resource was unregistered still holds
+         // the copy, which the submitted frame may be writing.
+         const auto it = Resources.find( move.ResourceId );
+         if (it != Resources.end()) {
+            Resource& resource = it->second;
+            if (resource.Buffer != nullptr) std::swap( *resource.Buffer, move.Buffer );
+            else std::swap( *resource.Image, move.Image );
+            std::swap( *resource.Memory, move.Memory );
+            if (resource.OnMoved) callbacks.emplace_back( resource.OnMoved );
+         }
+         defer_destruction( [this, move]() mutable { release( move ); } );
+      }
+      PendingMoves.clear();
+   }
+
+   for (const auto& callback : callbacks) callback( defer_destruction );
+   return static_cast<uint32_t>(callbacks.size());
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "descriptor_allocator.h"
+
+DescriptorAllocatorVK::DescriptorAllocatorVK(VkDevice device, uint32_t frame_count) :
+   Device( device ), Transient(frame_count)
+{
+}
+
+DescriptorAllocatorVK::~DescriptorAllocatorVK()
+{
+   for (auto pool : Persistent.Pools) vkDestroyDescriptorPool( Device, pool, nullptr );
+   for (const auto& list : Transient) {
+      for (auto pool : list.Pools) vkDestroyDescriptorPool( Device, pool, nullptr );
+   }
+}
+
+VkDescriptorPool DescriptorAllocatorVK::createPool(PoolList& list, VkDescriptorPoolCreateFlags flags)
+{
+   const uint32_t set_count = list.NextPoolSetCount;
+   std::array<VkDescriptorPoolSize, PoolSizeRatios.size()> pool_sizes{};
+   for (size_t i = 0; i < PoolSizeRatios.size(); ++i) {
+      pool_sizes[i].type = PoolSizeRatios[i].Type;
+      pool_sizes[i].descriptorCount =
+         std::max( static_cast<uint32_t>(PoolSizeRatios[i].Ratio * static_cast<float>(set_count)), 1u );
+   }
+
+   VkDescriptorPoolCreateInfo pool_info{};
+   pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+   pool_info.flags = flags;
+   pool_info.maxSets = set_count;
+   pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+   pool_info.pPoolSizes = pool_sizes.data();
+
+   VkDescriptorPool pool;
+   if (vkCreateDescriptorPool( Device, &pool_info, nullptr, &pool ) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create descriptor pool!");
+   }
+   list.Pools.emplace_back( pool );
+   list.NextPoolSetCount = std::min( set_count * 2, MaxPoolSetCount );
+   return pool;
+}
+
+VkResult DescriptorAllocatorVK::allocateFromPool(
+   VkDescriptorPool pool,
+   VkDescriptorSetLayout layout,
+   VkDescriptorSet& set
+)
+{
+   VkDescriptorSetAllocateInfo allocate_info{};
+   allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+   allocate_info.descriptorPool = pool;
+   allocate_info.descriptorSetCount = 1;
+   allocate_info.pSetLayouts = &layout;
+   const VkResult result = vkAllocateDescriptorSets( Device, &allocate_info, &set );
+   if (result != VK_SUCCESS && result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+      throw std::runtime_error("failed to allocate descriptor sets!");
+   }
+   return result;
+}
+
+VkDescriptorSet DescriptorAllocatorVK::allocateFromList(
+   PoolList& list,
+   VkDescriptorSetLayout layout,
+   VkDescriptorPoolCreateFlags flags,
+   VkDescriptorPool& pool
+)
+{
+   // Pools before the current one are full, unless sets can be freed and have been given back to them.
+   const bool freeable = (flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT) != 0;
+   const size_t pool_count = list.Pools.size();
+   VkDescriptorSet set = VK_NULL_HANDLE;
+   for (size_t i = 0; i < pool_count; ++i) {
+      const size_t index = (list.CurrentPool + i) % pool_count;
+      if (!freeable && index < list.CurrentPool) break;
+      if (allocateFromPool( list.Pools[index], layout, set ) == VK_SUCCESS) {
+         list.CurrentPool = index;
+         pool = list.Pools[index];
+         return set;
+      }
+   }
+
+   pool = createPool( list, flags );
+   list.CurrentPool = list.Pools.size() - 1;
+   if (allocateFromPool( pool, layout, set ) != VK_SUCCESS) {
+      throw std::runtime_error("failed to allocate descriptor sets!");
+   }
+   return set;
+}
+
+VkDescriptorSet DescriptorAllocatorVK::allocate(VkDescriptorSetLayout layout)
+{
+   std::lock_guard<std::mutex> lock( Mutex );
+   VkDescriptorPool pool;
+   const VkDescriptorSet set =
+      allocateFromList( Persistent, layout, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT, pool );
+   PersistentOwners.emplace( set, pool );
+   return set;
+}
+
+void DescriptorAllocatorVK::free(VkDescriptorSet descriptor_set) noexcept
+{
+   if (descriptor_set == VK_NULL_HANDLE) return;
+
+   std::lock_guard<std::mutex> lock( Mutex );
+   const auto it = PersistentOwners.find( descriptor_set );
+   assert( it != PersistentOwners.end() );
+   if (it == PersistentOwners.end()) return;
+
+   vkFreeDescriptorSets( Device, it->second, 1, &descriptor_set );
+   PersistentOwners.erase( it );
+}
+
+VkDescriptorSet DescriptorAllocatorVK::allocateTransient(uint32_t frame_index, VkDescriptorSetLayout layout)
+{
+   std::lock_guard<std::mutex> lock( Mutex );
+   VkDescriptorPool pool;
+   return allocateFromList( Transient[frame_index], layout, 0, pool );
+}
+
+void DescriptorAllocatorVK::resetFrame(uint32_t frame_index)
+{
+   std::lock_guard<std::mutex> lock( Mutex );
+   PoolList& list = Transient[frame_index];
+   for (auto pool : list.Pools) vkResetDescriptorPool( Device, pool, 0 );
+   list.CurrentPool = 0;
+}
+
+size_t DescriptorAllocatorVK::getPoolCount() const
+{
+   std::lock_guard<std::mutex> lock( Mutex );
+   size_t count = Persistent.Pools.size();
+   for (const auto& list : Transient) count += list.Pools.size();
+   return count;
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "ktx2_reader.h"
+
+KTX2ReaderVK::KTX2ReaderVK(const std::string& file_path) : Format( VK_FORMAT_UNDEFINED ), Width( 0 ), Height( 0 )
+{
+   std::ifstream file( file_path, std::ios::binary | std::ios::ate );
+   if (!file.is_open()) throw std::runtime_error("failed to open KTX2 texture!");
+
+   FileData.resize( static_cast<size_t>(file.tellg()) );
+   file.seekg( 0 );
+   file.read( reinterpret_cast<char*>(FileData.data()), static_cast<std::streamsize>(FileData.size()) );
+   if (FileData.size() < HeaderSize || std::memcmp( FileData.data(), Identifier.data(), Identifier.size() ) != 0) {
+      throw std::runtime_error("failed to read KTX2 texture header!");
+   }
+
+   Format = static_cast<VkFormat>(readUint32( 12 ));
+   Width = readUint32( 20 );
+   Height = readUint32( 24 );
+   const uint32_t depth = readUint32( 28 );
+   const uint32_t layer_count = readUint32( 32 );
+   const uint32_t face_count = readUint32( 36 );
+   const uint32_t level_count = std::max( readUint32( 40 ), 1u );
+   const uint32_t supercompression_scheme = readUint32( 44 );
+   if (!isSupportedFormat( Format )) throw std::runtime_error("failed to load KTX2 texture of unsupported format!");
+   if (supercompression_scheme != 0) throw std::runtime_error("failed to load supercompressed KTX2 texture!");
+   if (Width == 0 || Height == 0 || depth > 1 || layer_count > 1 || face_count != 1) {
+      throw std::runtime_error("failed to load KTX2 texture that is not a single 2D image!");
+   }
+   if (level_count > CommonVK::getMipLevelCount( Width, Height ) ||
+       FileData.size() < HeaderSize + level_count * LevelIndexEntrySize) {
+      throw std::runtime_error("failed to read KTX2 level index!");
+   }
+
+   Levels.resize( level_count );
+   for (uint32_t i = 0; i < level_count; ++i) {
+      Levels[i].ByteOffset = readUint64( HeaderSize + i * LevelIndexEntrySize );
+      Levels[i].ByteLength = readUint64( HeaderSize + i * LevelIndexEntrySize + 8 );
+      const VkDeviceSize expected_size = BlockCompressionVK::getLevelSize(
+         Format, std::max( Width >> i, 1u ), std::max( Height >> i, 1u )
+      );
+      // Both values come from the file, so their sum could wrap around instead of exceeding the file size.
+      const uint64_t file_size = FileData.size();
+      if (Levels[i].ByteLength < expected_size || Levels[i].ByteOffset > file_size ||
+          Levels[i].ByteLength > file_size - Levels[i].ByteOffset) {
+         throw std::runtime_error("failed to read KTX2 level data!");
+      }
+   }
+}
+
+bool KTX2ReaderVK::isKTX2File(const std::string& file_path)
+{
+   std::ifstream file( file_path, std::ios::binary );
+   std::array<uint8_t, Identifier.size()> identifier{};
+   file.read( reinterpret_cast<char*>(identifier.data()), static_cast<std::streamsize>(identifier.size()) );
+   return file.good() && identifier == Identifier;
+}
+
+uint32_t KTX2ReaderVK::readUint32(size_t offset) const
+{
+   uint32_t value;
+   std::memcpy( &value, FileData.data() + offset, sizeof( value ) );
+   return value;
+}
+
+uint64_t KTX2ReaderVK::readUint64(size_t offset) const
+{
+   uint64_t value;
+   std::memcpy( &value, FileData.data() + offset, sizeof( value ) );
+   return value;
+}
+
+bool KTX2ReaderVK::isSupportedFormat(VkFormat format)
+{
+   return format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB ||
+      BlockCompressionVK::isBlockCompressed( format );
+}
+
+TextureVK::ImageData KTX2ReaderVK::getImageData() const
+{
+   const bool sampled = CommonVK::isFormatSupported(
+      Format,
+      VK_IMAGE_TILING_OPTIMAL,
+      VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT
+   );
+   if (!sampled && !BlockCompressionVK::canDecode( Format )) {
+      throw std::runtime_error("failed to load KTX2 texture that can neither be sampled nor decoded!");
+   }
+
+   TextureVK::ImageData image_data;
+   image_data.Format = sampled ? Format :
+      BlockCompressionVK::isSRGB( Format ) ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+   image_data.Width = Width;
+   image_data.Height = Height;
+   image_data.LevelOffsets.clear();
+   for (uint32_t i = 0; i < static_cast<uint32_t>(Levels.size()); ++i) {
+      const uint32_t level_width = std::max( Width >> i, 1u );
+      const uint32_t level_height = std::max( Height >> i, 1u );
+      const VkDeviceSize level_size = BlockCompressionVK::getLevelSize( Format, level_width, level_height );
+      if (Levels[i].ByteLength < level_size) throw std::runtime_error("failed to read KTX2 level data!");
+
+      const uint8_t* level_data = FileData.data() + Levels[i].ByteOffset;
+      image_data.LevelOffsets.emplace_back( static_cast<VkDeviceSize>(image_data.Texels.size()) );
+      if (sampled) {
+         image_data.Texels.insert( image_data.Texels.end(), level_data, level_data + static_cast<size_t>(level_size) );
+      }
+      else {
+         image_data.Texels.resize( image_data.Texels.size() + static_cast<size_t>(level_width) * level_height * 4 );
+         BlockCompressionVK::decode(
+            Format, level_data, level_width, level_height, image_data.Texels.data() + image_data.LevelOffsets.back()
+         );
+      }
+   }
+   return image_data;
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "ktx2_writer.h"
+
+void KTX2WriterVK::writeUint32(std::vector<uint8_t>& file_data, size_t offset, uint32_t value)
+{
+   std::memcpy( file_data.data() + offset, &value, sizeof( value ) );
+}
+
+void KTX2WriterVK::writeUint64(std::vector<uint8_t>& file_data, size_t offset, uint64_t value)
+{
+   std::memcpy( file_data.data() + offset, &value, sizeof( value ) );
+}
+
+// A basic data format descriptor block as defined by the Khronos Data Format Specification.
+std::vector<uint32_t> KTX2WriterVK::getDataFormatDescriptor(VkFormat format)
+{
+   struct Sample
+   {
+      uint32_t BitOffset;
+      uint32_t BitLength;
+      uint32_t ChannelType;
+      uint32_t Upper;
+   };
+
+   uint32_t color_model;
+   std::vector<Sample> samples;
+   switch (format) {
+      case VK_FORMAT_R8G8B8A8_UNORM:
+      case VK_FORMAT_R8G8B8A8_SRGB: {
+         color_model = 1;
+         // The alpha channel of an sRGB format is stored linearly.
+         const uint32_t alpha_qualifier = format == VK_FORMAT_R8G8B8A8_SRGB ? 0x10 : 0;
+         samples = { { 0, 8, 0, 255 }, { 8, 8, 1, 255 }, { 16, 8, 2, 255 }, { 24, 8, 15 | alpha_qualifier, 255 } };
+         break;
+      }
+      case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+      case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+         color_model = 128;
+         samples = { { 0, 64, 0, 0xFFFFFFFF } };
+         break;
+      case VK_FORMAT_BC3_UNORM_BLOCK:
+      case VK_FORMAT_BC3_SRGB_BLOCK:
+         color_model = 130;
+         samples = { { 0, 64, 15, 0xFFFFFFFF }, { 64, 64, 0, 0xFFFFFFFF } };
+         break;
+      case VK_FORMAT_BC7_UNORM_BLOCK:
+      case VK_FORMAT_BC7_SRGB_BLOCK:
+         color_model = 134;
+         samples = { { 0, 128, 0, 0xFFFFFFFF } };
+         break;
+      default:
+         throw std::runtime_error("failed to describe the format of a KTX2 texture!");
+   }
+
+   const bool compressed = BlockCompressionVK::isBlockCompressed( format );
+   const uint32_t transfer_function = BlockCompressionVK::isSRGB( format ) ? 2 : 1;
+   const uint32_t block_dimension = compressed ? 3 : 0;
+   const uint32_t bytes_per_block = compressed ? BlockCompressionVK::getBlockSize( format ) : 4;
+   const auto block_size = static_cast<uint32_t>(24 + samples.size() * 16);
+
+   std::vector<uint32_t> descriptor = {
+      4 + block_size,
+      0,
+      2 | block_size << 16,
+      color_model | 1 << 8 | transfer_function << 16,
+      block_dimension | block_dimension << 8,
+      bytes_per_block,
+      0
+   };
+   for (const auto& sample : samples) {
+      descriptor.emplace_back( sample.BitOffset | (sample.BitLength - 1) << 16 | sample.ChannelType << 24 );
+      descriptor.emplace_back( 0 );
+      descriptor.emplace_back( 0 );
+      descriptor.emplace_back( sample.Upper );
+   }
+   return descriptor;
+}
+
+void KTX2WriterVK::write(const std::string& file_path, const TextureVK::ImageData& image_data)
+{
+   const VkFormat format = image_data.Format;
+   const std::vector<uint32_t> descriptor = getDataFormatDescriptor( format );
+   const size_t level_count = image_data.LevelOffsets.size();
+   const size_t descriptor_offset = KTX2ReaderVK::HeaderSize + level_count * KTX2ReaderVK::LevelIndexEntrySize;
+   const size_t descriptor_size = descriptor.size() * sizeof( uint32_t );
+   const bool compressed = BlockCompressionVK::isBlockCompressed( format );
+   const size_t alignment = compressed ? BlockCompressionVK::getBlockSize( format ) : 4;
+
+   std::vector<uint8_t> file_data( descriptor_offset + descriptor_size );
+   std::memcpy( file_data.data(), KTX2ReaderVK::Identifier.data(), KTX2ReaderVK::Identifier.size() );
+   writeUint32( file_data, 12, static_cast<uint32_t>(format) );
+   writeUint32( file_data, 16, 1 );
+   writeUint32( file_data, 20, image_data.Width );
+   writeUint32( file_data, 24, image_data.Height );
+   writeUint32( file_data, 28, 0 );
+   writeUint32( file_data, 32, 0 );
+   writeUint32( file_data, 36, 1 );
+   writeUint32( file_data, 40, static_cast<uint32_t>(level_count) );
+   writeUint32( file_data, 44, 0 );
+   writeUint32( file_data, 48, static_cast<uint32_t>(descriptor_offset) );
+   writeUint32( file_data, 52, static_cast<uint32_t>(descriptor_size) );
+   std::memcpy( file_data.data() + descriptor_offset, descriptor.data(), descriptor_size );
+
+   // Levels are stored from the smallest to the largest one.
+   for (size_t level = level_count; level-- > 0;) {
+      const size_t level_begin = static_cast<size_t>(image_data.LevelOffsets[level]);
+      const size_t level_end = level + 1 < level_count ?
+         static_cast<size_t>(image_data.LevelOffsets[level + 1]) : image_data.Texels.size();
+      file_data.resize( (file_data.size() + alignment - 1) / alignment * alignment );
+
+      const size_t index_offset = KTX2ReaderVK::HeaderSize + level * KTX2ReaderVK::LevelIndexEntrySize;
+      writeUint64( file_data, index_offset, file_data.size() );
+      writeUint64( file_data, index_offset + 8, level_end - level_begin );
+      writeUint64( file_data, index_offset + 16, level_end - level_begin );
+      file_data.insert(
+         file_data.end(),
+         image_data.Texels.begin() + static_cast<std::ptrdiff_t>(level_begin),
+         image_data.Texels.begin() + static_cast<std::ptrdiff_t>(level_end)
+      );
+   }
+
+   // Pool jobs and other processes that decode identical files write the same destination, so each write gets its own
+   // temporary file and only the rename is shared.
+   const std::string temporary_path = getTemporaryPath( file_path );
+   {
+      std::ofstream file( temporary_path, std::ios::binary | std::ios::trunc );
+      if (!file.is_open()) throw std::runtime_error("failed to create KTX2 texture!");
+      file.write( reinterpret_cast<const char*>(file_data.data()), static_cast<std::streamsize>(file_data.size()) );
+      if (!file.good()) throw std::runtime_error("failed to write KTX2 texture!");
+   }
+   std::filesystem::rename( temporary_path, file_path );
+}
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include "pipeline_registry.h"
+
+PipelineRegistryVK::PipelineRegistryVK(VkDevice device, VkPipelineCache pipeline_cache) :
+   Device( device ), PipelineCache( pipeline_cache ), GraphicsPipelineRequests( 0 )
+{
+}
+
+PipelineRegistryVK::~PipelineRegistryVK()
+{
+   for (const auto& pipeline : GraphicsPipelines) vkDestroyPipeline( Device, pipeline.second, nullptr );
+   for (const auto& layout : PipelineLayouts) vkDestroyPipelineLayout( Device, layout.second, nullptr );
+   for (const auto& layout : DescriptorSetLayouts) vkDestroyDescriptorSetLayout( Device, layout.second, nullptr );
+   for (const auto& render_pass : RenderPasses) vkDestroyRenderPass( Device, render_pass.second, nullptr );
+   for (const auto& shader_module : ShaderModules) vkDestroyShaderModule( Device, shader_module.second, nullptr );
+}
+
+VkShaderModule PipelineRegistryVK::getShaderModule(const std::vector<char>& code)
+{
+   if (code.size() % sizeof( uint32_t ) != 0) throw std::runtime_error("failed to create shader module!");
+
+   Key key(code.size() / sizeof( uint32_t ));
+   std::memcpy( key.data(), code.data(), code.size() );
+
+   std::lock_guard<std::mutex> lock( Mutex );
+   const auto it = ShaderModules.find( key );
+   if (it != ShaderModules.end()) return it->second;
+
+   VkShaderModuleCreateInfo create_info{};
+   create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+   create_info.codeSize = code.size();
+   create_info.pCode = key.data();
+
+   VkShaderModule shader_module;
+   const VkResult result = vkCreateShaderModule( Device, &create_info, nullptr, &shader_module );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to create shader module!");
+   ShaderModules.emplace( std::move( key ), shader_module );
+   return shader_module;
+}
+
+VkRenderPass PipelineRegistryVK::getRenderPass(VkFormat color_format, VkFormat depth_format)
+{
+   const Key key = { static_cast<uint32_t>(color_format), static_cast<uint32_t>(depth_format) };
+
+   std::lock_guard<std::mutex> lock( Mutex );
+   const auto it = RenderPasses.find( key );
+   if (it != RenderPasses.end()) return it->second;
+
+   VkAttachmentDescription color_attachment{};
+   color_attachment.format = color_format;
+   color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+   color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+   color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+   color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+   color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+   color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+   color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+   VkAttachmentDescription depth_attachment{};
+   depth_attachment.format = depth_format;
+   depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+   depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+   depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+   depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+   depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+   depth_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+   depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+   VkAttachmentReference color_attachment_ref{};
+   color_attachment_ref.attachment = 0;
+   color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+   VkAttachmentReference depth_attachment_ref{};
+   depth_attachment_ref.attachment = 1;
+   depth_attachment_ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+   VkSubpassDescription subpass{};
+   subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+   subpass.colorAttachmentCount = 1;
+   subpass.pColorAttachments = &color_attachment_ref;
+   subpass.pDepthStencilAttachment = &depth_attachment_ref;
+
+   VkSubpassDependency dependency{};
+   dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+   dependency.dstSubpass = 0;
+   dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+   dependency.srcAccessMask = 0;
+   dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+   dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+   std::array<VkAttachmentDescription, 2> attachments = { color_attachment, depth_attachment };
+   VkRenderPassCreateInfo render_pass_info{};
+   render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+   render_pass_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+   render_pass_info.pAttachments = attachments.data();
+   render_pass_info.subpassCount = 1;
+   render_pass_info.pSubpasses = &subpass;
+   render_pass_info.dependencyCount = 1;
+   render_pass_info.pDependencies = &dependency;
+
+   VkRenderPass render_pass;
+   const VkResult result = vkCreateRenderPass( Device, &render_pass_info, nullptr, &render_pass );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to create render pass!");
+   RenderPasses.emplace( key, render_pass );
+   return render_pass;
+}
+
+VkDescriptorSetLayout PipelineRegistryVK::getDescriptorSetLayout(
+   const std::vector<VkDescriptorSetLayoutBinding>& bindings
+)
+{
+   Key key;
+   for (const auto& binding : bindings) {
+      if (binding.pImmutableSamplers != nullptr) {
+         throw std::runtime_error("failed to cache a descriptor set layout with immutable samplers!");
+      }
+      key.emplace_back( binding.binding );
+      key.emplace_back( static_cast<uint32_t>(binding.descriptorType) );
+      key.emplace_back( binding.descriptorCount );
+      key.emplace_back( binding.stageFlags );
+   }
+
+   std::lock_guard<std::mutex> lock( Mutex );
+   const auto it = DescriptorSetLayouts.find( key );
+   if (it != DescriptorSetLayouts.end()) return it->second;
+
+   VkDescriptorSetLayoutCreateInfo layout_info{};
+   layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+   layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+   layout_info.pBindings = bindings.data();
+
+   VkDescriptorSetLayout descriptor_set_layout;
+   const VkResult result = vkCreateDescriptorSetLayout( Device, &layout_info, nullptr, &descriptor_set_layout );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to create descriptor set layout!");
+   DescriptorSetLayouts.emplace( std::move( key ), descriptor_set_layout );
+   return descriptor_set_layout;
+}
+
+VkPipelineLayout PipelineRegistryVK::getPipelineLayout(
+   const std::vector<VkDescriptorSetLayout>& set_layouts,
+   const std::vector<VkPushConstantRange>& push_constant_ranges
+)
+{
+   // Set layouts come from this registry, so equal layouts already have equal handles.
+   Key key;
+   for (const auto set_layout : set_layouts) appendHandle( key, set_layout );
+   for (const auto& range : push_constant_ranges) {
+      key.emplace_back( range.stageFlags );
+      key.emplace_back( range.offset );
+      key.emplace_back( range.size );
+   }
+
+   std::lock_guard<std::mutex> lock( Mutex );
+   const auto it = PipelineLayouts.find( key );
+   if (it != PipelineLayouts.end()) return it->second;
+
+   VkPipelineLayoutCreateInfo pipeline_layout_info{};
+   pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+   pipeline_layout_info.setLayoutCount = static_cast<uint32_t>(set_layouts.size());
+   pipeline_layout_info.pSetLayouts = set_layouts.data();
+   pipeline_layout_info.pushConstantRangeCount = static_cast<uint32_t>(push_constant_ranges.size());
+   pipeline_layout_info.pPushConstantRanges = push_constant_ranges.data();
+
+   VkPipelineLayout pipeline_layout;
+   const VkResult result = vkCreatePipelineLayout( Device, &pipeline_layout_info, nullptr, &pipeline_layout );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to create pipeline layout!");
+   PipelineLayouts.emplace( std::move( key ), pipeline_layout );
+   return pipeline_layout;
+}
+
+VkPipeline PipelineRegistryVK::getGraphicsPipeline(const GraphicsPipelineDescription& description)
+{
+   Key key;
+   appendHandle( key, description.VertexShader );
+   appendHandle( key, description.FragmentShader );
+   key.emplace_back( static_cast<uint32_t>(description.VertexBindings.size()) );
+   for (const auto& binding : description.VertexBindings) {
+      key.emplace_back( binding.binding );
+      key.emplace_back( binding.stride );
+      key.emplace_back( static_cast<uint32_t>(binding.inputRate) );
+   }
+   key.emplace_back( static_cast<uint32_t>(description.VertexAttributes.size()) );
+   for (const auto& attribute : description.VertexAttributes) {
+      key.emplace_back( attribute.location );
+      key.emplace_back( attribute.binding );
+      key.emplace_back( static_cast<uint32_t>(attribute.format) );
+      key.emplace_back( attribute.offset );
+   }
+   key.emplace_back( static_cast<uint32_t>(description.Topology) );
+   key.emplace_back( static_cast<uint32_t>(description.PolygonMode) );
+   key.emplace_back( description.CullMode );
+   key.emplace_back( static_cast<uint32_t>(description.FrontFace) );
+   key.emplace_back( description.DepthTestEnable );
+   key.emplace_back( description.DepthWriteEnable );
+   key.emplace_back( static_cast<uint32_t>(description.DepthCompareOp) );
+   const VkPipelineColorBlendAttachmentState& blend = description.ColorBlendAttachment;
+   key.emplace_back( blend.blendEnable );
+   key.emplace_back( static_cast<uint32_t>(blend.srcColorBlendFactor) );
+   key.emplace_back( static_cast<uint32_t>(blend.dstColorBlendFactor) );
+   key.emplace_back( static_cast<uint32_t>(blend.colorBlendOp) );
+   key.emplace_back( static_cast<uint32_t>(blend.srcAlphaBlendFactor) );
+   key.emplace_back( static_cast<uint32_t>(blend.dstAlphaBlendFactor) );
+   key.emplace_back( static_cast<uint32_t>(blend.alphaBlendOp) );
+   key.emplace_back( blend.colorWriteMask );
+   appendHandle( key, description.Layout );
+   appendHandle( key, description.RenderPass );
+   key.emplace_back( description.Subpass );
+
+   std::lock_guard<std::mutex> lock( Mutex );
+   GraphicsPipelineRequests++;
+   const auto it = GraphicsPipelines.find( key );
+   if (it != GraphicsPipelines.end()) return it->second;
+
+   const VkPipeline pipeline = createGraphicsPipeline( description );
+   GraphicsPipelines.emplace( std::move( key ), pipeline );
+   return pipeline;
+}
+
+VkPipeline PipelineRegistryVK::createGraphicsPipeline(const GraphicsPipelineDescription& description) const
+{
+   VkPipelineShaderStageCreateInfo vert_shader_stage_info{};
+   vert_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+   vert_shader_stage_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
+   vert_shader_stage_info.module = description.VertexShader;
+   vert_shader_stage_info.pName = "main";
+
+   VkPipelineShaderStageCreateInfo frag_shader_stage_info{};
+   frag_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+   frag_shader_stage_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+   frag_shader_stage_info.module = description.FragmentShader;
+   frag_shader_stage_info.pName = "main";
+
+   VkPipelineVertexInputStateCreateInfo vertex_input_info{};
+   vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+   vertex_input_info.vertexBindingDescriptionCount = static_cast<uint32_t>(description.VertexBindings.size());
+   vertex_input_info.pVertexBindingDescriptions = description.VertexBindings.data();
+   vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(description.VertexAttributes.size());
+   vertex_input_info.pVertexAttributeDescriptions = description.VertexAttributes.data();
+
+   VkPipelineInputAssemblyStateCreateInfo input_assembly{};
+   input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+   input_assembly.topology = description.Topology;
+   input_assembly.primitiveRestartEnable = VK_FALSE;
+
+   // The viewport and scissor are set when recording, so the pipeline works for any render target size.
+   VkPipelineViewportStateCreateInfo viewport_state{};
+   viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+   viewport_state.viewportCount = 1;
+   viewport_state.scissorCount = 1;
+
+   constexpr std::array<VkDynamicState, 2> dynamic_states = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+   VkPipelineDynamicStateCreateInfo dynamic_state{};
+   dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+   dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
+   dynamic_state.pDynamicStates = dynamic_states.data();
+
+   VkPipelineRasterizationStateCreateInfo rasterizer{};
+   rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+   rasterizer.depthClampEnable = VK_FALSE;
+   rasterizer.rasterizerDiscardEnable = VK_FALSE;
+   rasterizer.polygonMode = description.PolygonMode;
+   rasterizer.lineWidth = 1.0f;
+   rasterizer.cullMode = description.CullMode;
+   rasterizer.frontFace = description.FrontFace;
+   rasterizer.depthBiasEnable = VK_FALSE;
+
+   VkPipelineMultisampleStateCreateInfo multisampling{};
+   multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+   multisampling.sampleShadingEnable = VK_FALSE;
+   multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+   VkPipelineDepthStencilStateCreateInfo depth_stencil{};
+   depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+   depth_stencil.depthTestEnable = description.DepthTestEnable;
+   depth_stencil.depthWriteEnable = description.DepthWriteEnable;
+   depth_stencil.depthCompareOp = description.DepthCompareOp;
+   depth_stencil.depthBoundsTestEnable = VK_FALSE;
+   depth_stencil.stencilTestEnable = VK_FALSE;
+
+   VkPipelineColorBlendStateCreateInfo color_blending{};
+   color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+   color_blending.logicOpEnable = VK_FALSE;
+   color_blending.logicOp = VK_LOGIC_OP_COPY;
+   color_blending.attachmentCount = 1;
+   color_blending.pAttachments = &description.ColorBlendAttachment;
+
+   std::array<VkPipelineShaderStageCreateInfo, 2> shader_stages = { vert_shader_stage_info, frag_shader_stage_info };
+   VkGraphicsPipelineCreateInfo pipeline_info{};
+   pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+   pipeline_info.stageCount = static_cast<uint32_t>(shader_stages.size());
+   pipeline_info.pStages = shader_stages.data();
+   pipeline_info.pVertexInputState = &vertex_input_info;
+   pipeline_info.pInputAssemblyState = &input_assembly;
+   pipeline_info.pViewportState = &viewport_state;
+   pipeline_info.pRasterizationState = &rasterizer;
+   pipeline_info.pMultisampleState = &multisampling;
+   pipeline_info.pDepthStencilState = &depth_stencil;
+   pipeline_info.pColorBlendState = &color_blending;
+   pipeline_info.pDynamicState = &dynamic_state;
+   pipeline_info.layout = description.Layout;
+   pipeline_info.renderPass = description.RenderPass;
+   pipeline_info.subpass = description.Subpass;
+   pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
+
+   VkPipeline pipeline;
+   const VkResult result = vkCreateGraphicsPipelines( Device, PipelineCache, 1, &pipeline_info, nullptr, &pipeline );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to create graphics pipeline!");
+   return pipeline;
+}
+
+void PipelineRegistryVK::printStatistics(std::ostream& stream) const
+{
+   std::lock_guard<std::mutex> lock( Mutex );
+   stream << "pipeline registry: " << GraphicsPipelines.size() << " graphics pipelines for " << GraphicsPipelineRequests
+      << " requests, " << PipelineLayouts.size() << " pipeline layouts, " << DescriptorSetLayouts.size()
+      << " descriptor set layouts, " << RenderPasses.size() << " render passes, " << ShaderModules.size()
+      << " shader modules\n";
+}
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "pixel_conversion.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PIXEL_CONVERSION_USE_AVX2
+#endif
+#if defined(__SSSE3__) || defined(__AVX2__)
+#include <tmmintrin.h>
+#define PIXEL_CONVERSION_USE_SSSE3
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PIXEL_CONVERSION_USE_SSE2
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PIXEL_CONVERSION_USE_NEON
+#endif
+
+void PixelConversionVK::convertToRGBA(
+   Layout layout,
+   const uint8_t* src,
+   size_t src_pitch,
+   uint32_t width,
+   uint32_t height,
+   bool premultiply_alpha,
+   uint8_t* dst
+)
+{
+   const size_t dst_pitch = static_cast<size_t>(width) * 4;
+   for (uint32_t y = 0; y < height; ++y) {
+      const uint8_t* src_row = src + y * src_pitch;
+      uint8_t* dst_row = dst + y * dst_pitch;
+      switch (layout) {
+         case Layout::RGB:
+         case Layout::BGR:
+            expandToRGBA( src_row, width, layout == Layout::BGR, dst_row );
+            break;
+         case Layout::RGBA:
+            std::memcpy( dst_row, src_row, dst_pitch );
+            if (premultiply_alpha) premultiplyAlpha( dst_row, width );
+            break;
+         case Layout::BGRA:
+            swapRedBlue( src_row, width, dst_row );
+            if (premultiply_alpha) premultiplyAlpha( dst_row, width );
+            break;
+      }
+   }
+}
+
+void PixelConversionVK::swapRedBlue(const uint8_t* src, uint32_t width, uint8_t* dst)
+{
+   uint32_t x = 0;
+#if defined(PIXEL_CONVERSION_USE_AVX2)
+   const __m256i order = _mm256_setr_epi8(
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15
+   );
+   for (; x + 8 <= width; x += 8) {
+      const __m256i texels = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(src + x * 4) );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>(dst + x * 4), _mm256_shuffle_epi8( texels, order ) );
+   }
+#elif defined(PIXEL_CONVERSION_USE_SSE2)
+   // Red and blue are two bytes apart in every 32-bit texel, so they swap places with a pair of shifts.
+   const __m128i green_alpha = _mm_set1_epi32( static_cast<int>(0xFF00FF00u) );
+   const __m128i red_blue = _mm_set1_epi32( 0x00FF00FF );
+   for (; x + 4 <= width; x += 4) {
+      const __m128i texels = _mm_loadu_si128( reinterpret_cast<const __m128i*>(src + x * 4) );
+      const __m128i colors = _mm_and_si128( texels, red_blue );
+      const __m128i swapped = _mm_or_si128(
+         _mm_and_si128( texels, green_alpha ),
+         _mm_or_si128( _mm_srli_epi32( colors, 16 ), _mm_slli_epi32( colors, 16 ) )
+      );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(dst + x * 4), swapped );
+   }
+#elif defined(PIXEL_CONVERSION_USE_NEON)
+   for (; x + 16 <= width; x += 16) {
+      uint8x16x4_t texels = vld4q_u8( src + x * 4 );
+      std::swap( texels.val[0], texels.val[2] );
+      vst4q_u8( dst + x * 4, texels );
+   }
+#endif
+   for (; x < width; ++x) {
+      dst[x * 4] = src[x * 4 + 2];
+      dst[x * 4 + 1] = src[x * 4 + 1];
+      dst[x * 4 + 2] = src[x * 4];
+      dst[x * 4 + 3] = src[x * 4 + 3];
+   }
+}
+
+void PixelConversionVK::expandToRGBA(const uint8_t* src, uint32_t width, bool swap_red_blue, uint8_t* dst)
+{
+   uint32_t x = 0;
+#if defined(PIXEL_CONVERSION_USE_SSSE3)
+   // Each load reads 16 bytes but only uses the 12 bytes of four texels, so the loop stops early enough not to read
+   // past the end of the row.
+   const __m128i order = swap_red_blue ?
+      _mm_setr_epi8( 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1 ) :
+      _mm_setr_epi8( 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 );
+   const __m128i opaque = _mm_set1_epi32( static_cast<int>(0xFF000000u) );
+   for (; x + 6 <= width; x += 4) {
+      const __m128i texels = _mm_loadu_si128( reinterpret_cast<const __m128i*>(src + x * 3) );
+      _mm_storeu_si128(
+         reinterpret_cast<__m128i*>(dst + x * 4),
+         _mm_or_si128( _mm_shuffle_epi8( texels, order ), opaque )
+      );
+   }
+#elif defined(PIXEL_CONVERSION_USE_SSE2)
+   // Without a byte shuffle, the four texels are shifted down to the first lane of separate registers and interleaved
+   // back together. Red and blue then swap places with a pair of shifts, as in swapRedBlue.
+   const __m128i color = _mm_set1_epi32( 0x00FFFFFF );
+   const __m128i opaque = _mm_set1_epi32( static_cast<int>(0xFF000000u) );
+   const __m128i green_alpha = _mm_set1_epi32( static_cast<int>(0xFF00FF00u) );
+   const __m128i red_blue = _mm_set1_epi32( 0x00FF00FF );
+   for (; x + 6 <= width; x += 4) {
+      const __m128i texels = _mm_loadu_si128( reinterpret_cast<const __m128i*>(src + x * 3) );
+      const __m128i gathered = _mm_unpacklo_epi64(
+         _mm_unpacklo_epi32( texels, _mm_srli_si128( texels, 3 ) ),
+         _mm_unpacklo_epi32( _mm_srli_si128( texels, 6 ), _mm_srli_si128( texels, 9 ) )
+      );
+      __m128i expanded = _mm_or_si128( _mm_and_si128( gathered, color ), opaque );
+      if (swap_red_blue) {
+         const __m128i colors = _mm_and_si128( expanded, red_blue );
+         expanded = _mm_or_si128(
+            _mm_and_si128( expanded, green_alpha ),
+            _mm_or_si128( _mm_srli_epi32( colors, 16 ), _mm_slli_epi32( colors, 16 ) )
+         );
+      }
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(dst + x * 4), expanded );
+   }
+#elif defined(PIXEL_CONVERSION_USE_NEON)
+   for (; x + 16 <= width; x += 16) {
+      const uint8x16x3_t texels = vld3q_u8( src + x * 3 );
+      uint8x16x4_t expanded;
+      expanded.val[0] = swap_red_blue ? texels.val[2] : texels.val[0];
+      expanded.val[1] = texels.val[1];
+      expanded.val[2] = swap_red_blue ? texels.val[0] : texels.val[2];
+      expanded.val[3] = vdupq_n_u8( 255 );
+      vst4q_u8( dst + x * 4, expanded );
+   }
+#endif
+   const uint32_t red = swap_red_blue ? 2 : 0;
+   for (; x < width; ++x) {
+      dst[x * 4] = src[x * 3 + red];
+      dst[x * 4 + 1] = src[x * 3 + 1];
+      dst[x * 4 + 2] = src[x * 3 + 2 - red];
+      dst[x * 4 + 3] = 255;
+   }
+}
+
+// Scales the color channels by alpha with an exactly rounded division by 255: with t = c * a + 128,
+// the result is (t + (t >> 8)) >> 8.
+void PixelConversionVK::premultiplyAlpha(uint8_t* texels, uint32_t width)
+{
+   uint32_t x = 0;
+#if defined(PIXEL_CONVERSION_USE_SSE2)
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i rounding = _mm_set1_epi16( 128 );
+   // The alpha lane is multiplied by 255, which the division turns back into the original alpha.
+   const __m128i alpha_lanes = _mm_setr_epi16( 0, 0, 0, -1, 0, 0, 0, -1 );
+   const __m128i alpha_factor = _mm_setr_epi16( 0, 0, 0, 255, 0, 0, 0, 255 );
+   const auto multiply = [&](__m128i channels) {
+      __m128i alphas = _mm_shufflelo_epi16( channels, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+      alphas = _mm_shufflehi_epi16( alphas, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+      alphas = _mm_or_si128( _mm_andnot_si128( alpha_lanes, alphas ), alpha_factor );
+      const __m128i products = _mm_add_epi16( _mm_mullo_epi16( channels, alphas ), rounding );
+      return _mm_srli_epi16( _mm_add_epi16( products, _mm_srli_epi16( products, 8 ) ), 8 );
+   };
+   for (; x + 4 <= width; x += 4) {
+      const __m128i texel_block = _mm_loadu_si128( reinterpret_cast<const __m128i*>(texels + x * 4) );
+      const __m128i low = multiply( _mm_unpacklo_epi8( texel_block, zero ) );
+      const __m128i high = multiply( _mm_unpackhi_epi8( texel_block, zero ) );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(texels + x * 4), _mm_packus_epi16( low, high ) );
+   }
+#elif defined(PIXEL_CONVERSION_USE_NEON)
+   const auto multiply = [](uint8x16_t channel, uint8x16_t alpha) {
+      const uint16x8_t low = vmull_u8( vget_low_u8( channel ), vget_low_u8( alpha ) );
+      const uint16x8_t high = vmull_u8( vget_high_u8( channel ), vget_high_u8( alpha ) );
+      return vcombine_u8(
+         vrshrn_n_u16( vrsraq_n_u16( low, low, 8 ), 8 ),
+         vrshrn_n_u16( vrsraq_n_u16( high, high, 8 ), 8 )
+      );
+   };
+   for (; x + 16 <= width; x += 16) {
+      uint8x16x4_t texel_block = vld4q_u8( texels + x * 4 );
+      for (int c = 0; c < 3; ++c) texel_block.val[c] = multiply( texel_block.val[c], texel_block.val[3] );
+      vst4q_u8( texels + x * 4, texel_block );
+   }
+#endif
+   for (; x < width; ++x) {
+      const uint32_t alpha = texels[x * 4 + 3];
+      for (uint32_t c = 0; c < 3; ++c) {
+         const uint32_t product = texels[x * 4 + c] * alpha + 128;
+         texels[x * 4 + c] = static_cast<uint8_t>((product + (product >> 8)) >> 8);
+      }
+   }
+}
+
+float PixelConversionVK::decodeSRGB(float value)
+{
+   return value <= 0.04045f ? value / 12.92f : std::pow( (value + 0.055f) / 1.055f, 2.4f );
+}
+
+float PixelConversionVK::encodeSRGB(float value)
+{
+   return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow( value, 1.0f / 2.4f ) - 0.055f;
+}
+
+const std::array<uint16_t, 256>& PixelConversionVK::getSRGBDecodeTable()
+{
+   static const std::array<uint16_t, 256> table = []() {
+      std::array<uint16_t, 256> decoded{};
+      for (size_t i = 0; i < decoded.size(); ++i) {
+         const float linear = decodeSRGB( static_cast<float>(i) / 255.0f );
+         decoded[i] = static_cast<uint16_t>(std::lround( linear * 65535.0f ));
+      }
+      return decoded;
+   }();
+   return table;
+}
+
+const std::vector<uint8_t>& PixelConversionVK::getSRGBEncodeTable()
+{
+   static const std::vector<uint8_t> table = []() {
+      std::vector<uint8_t> encoded(65536);
+      for (size_t i = 0; i < encoded.size(); ++i) {
+         const float srgb = encodeSRGB( static_cast<float>(i) / 65535.0f );
+         encoded[i] = static_cast<uint8_t>(std::lround( std::clamp( srgb, 0.0f, 1.0f ) * 255.0f ));
+      }
+      return encoded;
+   }();
+   return table;
+}
+
+void PixelConversionVK::decodeSRGB16(uint16_t* values, size_t count)
+{
+   static const std::vector<uint16_t> table = []() {
+      std::vector<uint16_t> decoded(65536);
+      for (size_t i = 0; i < decoded.size(); ++i) {
+         const float linear = decodeSRGB( static_cast<float>(i) / 65535.0f );
+         decoded[i] = static_cast<uint16_t>(std::lround( linear * 65535.0f ));
+      }
+      return decoded;
+   }();
+   for (size_t i = 0; i < count; ++i) values[i] = table[values[i]];
+}
\ No newline at end of file
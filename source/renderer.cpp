@@ -3,16 +3,35 @@
 RendererVK::RendererVK() :
    FrameWidth( 1280 ), FrameHeight( 720 ), Common( std::make_shared<CommonVK>() ), Window( nullptr ), Instance{},
    Surface{}, SwapChain{}, SwapChainImageFormat{}, SwapChainExtent{}, DepthImage{}, DepthImageMemory{},
-   DepthImageView{}, VertexBuffer{}, VertexBufferMemory{}, CurrentFrame( 0 ), FramebufferResized( false )
+   DepthImageView{}, VertexBuffer{}, VertexBufferMemory{}, VertexBufferUploadTicket( 0 ),
+   VertexBufferDefragmentationId( 0 ), LightUniformOffset( 0 ), SceneDescriptorSet{}, ObjectDescriptorSet{},
+   CurrentFrame( 0 ), SubmittedFrames( 0 ), FramebufferResized( false ), FramesSinceDefragmentation( 0 )
 {
 }
 
 RendererVK::~RendererVK()
 {
    VkDevice device = CommonVK::getDevice();
+   ThreadPool.reset();
+   TextureCache.reset();
+   Uploader.reset();
+   flushDeletionQueue( false );
    cleanupSwapChain();
-   vkDestroyBuffer( device, VertexBuffer, nullptr );
-   vkFreeMemory( device, VertexBufferMemory, nullptr );
+   UpperSquareObject.reset();
+   LowerSquareObject.reset();
+   Shader.reset();
+   CommonVK::destroyPipelineRegistry();
+   CommonVK::destroyPipelineCache();
+   CommonVK::destroyDescriptorAllocator();
+   Defragmenter->unregister( VertexBufferDefragmentationId );
+   CommonVK::destroyBuffer( VertexBuffer, VertexBufferMemory );
+   for (size_t i = 0; i < SceneUniformBuffers.size(); ++i) {
+      CommonVK::destroyBuffer( SceneUniformBuffers[i], SceneUniformBuffersMemory[i] );
+   }
+   UniformRing.reset();
+   Defragmenter.reset();
+   CommonVK::destroySamplers();
+   CommonVK::destroyAllocator();
    for (size_t i = 0; i < CommonVK::getMaxFramesInFlight(); i++) {
       vkDestroySemaphore( device, RenderFinishedSemaphores[i], nullptr );
       vkDestroySemaphore( device, ImageAvailableSemaphores[i], nullptr );
@@ -31,14 +50,9 @@ RendererVK::~RendererVK()
 
 void RendererVK::cleanupSwapChain()
 {
-   UpperSquareObject.reset();
-   LowerSquareObject.reset();
-   Shader.reset();
-
    VkDevice device = CommonVK::getDevice();
    vkDestroyImageView( device, DepthImageView, nullptr );
-   vkDestroyImage( device, DepthImage, nullptr );
-   vkFreeMemory( device, DepthImageMemory, nullptr );
+   CommonVK::destroyImage( DepthImage, DepthImageMemory );
    for (auto framebuffer : SwapChainFramebuffers) {
       vkDestroyFramebuffer( device, framebuffer, nullptr );
    }
@@ -48,15 +62,57 @@ void RendererVK::cleanupSwapChain()
    vkDestroySwapchainKHR( device, SwapChain, nullptr );
 }
 
+void RendererVK::retireSwapChain()
+{
+   // SwapChain itself stays set, since the next one is created from it.
+   deferDestruction(
+      [swap_chain = SwapChain, image_views = std::move( SwapChainImageViews ),
+       framebuffers = std::move( SwapChainFramebuffers ), depth_image = DepthImage,
+       depth_image_memory = DepthImageMemory, depth_image_view = DepthImageView]() mutable {
+         VkDevice device = CommonVK::getDevice();
+         vkDestroyImageView( device, depth_image_view, nullptr );
+         CommonVK::destroyImage( depth_image, depth_image_memory );
+         for (auto framebuffer : framebuffers) vkDestroyFramebuffer( device, framebuffer, nullptr );
+         for (auto image_view : image_views) vkDestroyImageView( device, image_view, nullptr );
+         vkDestroySwapchainKHR( device, swap_chain, nullptr );
+      }
+   );
+   SwapChainImageViews.clear();
+   SwapChainFramebuffers.clear();
+   DepthImage = VK_NULL_HANDLE;
+   DepthImageMemory = MemoryAllocatorVK::Allocation();
+   DepthImageView = VK_NULL_HANDLE;
+}
+
+void RendererVK::deferDestruction(std::function<void()> destroy)
+{
+   DeletionQueue.emplace_back( SubmittedFrames, std::move( destroy ) );
+}
+
+void RendererVK::flushDeletionQueue(bool wait_for_frames)
+{
+   // Frames are submitted round-robin over the fences, so once the fence of the current frame has been waited on, every
+   // frame up to SubmittedFrames - MaxFramesInFlight has finished.
+   const auto max_frames_in_flight = static_cast<uint64_t>(CommonVK::getMaxFramesInFlight());
+   while (!DeletionQueue.empty()) {
+      const uint64_t retired_at = DeletionQueue.front().first;
+      if (wait_for_frames && retired_at + max_frames_in_flight > SubmittedFrames + 1) break;
+      DeletionQueue.front().second();
+      DeletionQueue.pop_front();
+   }
+}
+
 void RendererVK::initializeWindow()
 {
    glfwInit();
    glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
-   glfwWindowHint( GLFW_RESIZABLE, GLFW_FALSE );
+   glfwWindowHint( GLFW_RESIZABLE, GLFW_TRUE );
    Window = glfwCreateWindow(
       static_cast<int>(FrameWidth), static_cast<int>(FrameHeight),
       "Vulkan", nullptr, nullptr
    );
+   glfwSetWindowUserPointer( Window, this );
+   glfwSetFramebufferSizeCallback( Window, framebufferResizeCallback );
 }
 
 #ifdef _DEBUG
@@ -180,7 +236,9 @@ void RendererVK::createSwapChain()
    create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
    create_info.presentMode = present_mode;
    create_info.clipped = VK_TRUE;
-   create_info.oldSwapchain = VK_NULL_HANDLE;
+   // Images the presentation engine still holds from the old swap chain can be reused, and it keeps presenting while
+   // the new one is set up.
+   create_info.oldSwapchain = SwapChain;
 
    const VkResult result = vkCreateSwapchainKHR(
       CommonVK::getDevice(),
@@ -236,33 +294,114 @@ void RendererVK::createImageViews()
    }
 }
 
+void RendererVK::createUniformRingBuffer()
+{
+   UniformRing = std::make_shared<UniformRingBufferVK>( 1024 * 1024 );
+}
+
+void RendererVK::createSceneUniformBuffers()
+{
+   const VkDeviceSize alignment = std::max<VkDeviceSize>(
+      CommonVK::getPhysicalDeviceProperties().limits.minUniformBufferOffsetAlignment, 1
+   );
+   LightUniformOffset = (sizeof( SceneUniformBufferObject ) + alignment - 1) / alignment * alignment;
+
+   const int max_frames_in_flight = CommonVK::getMaxFramesInFlight();
+   SceneUniformBuffers.resize( max_frames_in_flight );
+   SceneUniformBuffersMemory.resize( max_frames_in_flight );
+   for (size_t i = 0; i < max_frames_in_flight; ++i) {
+      CommonVK::createBuffer(
+         LightUniformOffset + sizeof( LightUniformBufferObject ),
+         VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+         MemoryAllocatorVK::Usage::CpuToGpu,
+         SceneUniformBuffers[i],
+         SceneUniformBuffersMemory[i]
+      );
+   }
+}
+
+// The scene and object sets are recreated every frame from the transient pools of the frame, which are recycled as a
+// whole here, once the fence of the frame has signaled, instead of freeing their sets one by one.
+void RendererVK::allocateFrameDescriptorSets()
+{
+   DescriptorAllocatorVK* descriptor_allocator = CommonVK::getDescriptorAllocator();
+   descriptor_allocator->resetFrame( CurrentFrame );
+   SceneDescriptorSet =
+      descriptor_allocator->allocateTransient( CurrentFrame, Shader->getSceneDescriptorSetLayout() );
+   ObjectDescriptorSet =
+      descriptor_allocator->allocateTransient( CurrentFrame, Shader->getObjectDescriptorSetLayout() );
+
+   std::array<VkDescriptorBufferInfo, 3> buffer_infos{};
+   buffer_infos[0].buffer = SceneUniformBuffers[CurrentFrame];
+   buffer_infos[0].offset = 0;
+   buffer_infos[0].range = sizeof( SceneUniformBufferObject );
+   buffer_infos[1].buffer = SceneUniformBuffers[CurrentFrame];
+   buffer_infos[1].offset = LightUniformOffset;
+   buffer_infos[1].range = sizeof( LightUniformBufferObject );
+   buffer_infos[2].buffer = UniformRing->getBuffer( CurrentFrame );
+   buffer_infos[2].offset = 0;
+   buffer_infos[2].range = ObjectVK::getObjectUniformBufferSize();
+
+   std::array<VkWriteDescriptorSet, 3> descriptor_writes{};
+   for (uint32_t j = 0; j < descriptor_writes.size(); ++j) {
+      descriptor_writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      descriptor_writes[j].dstArrayElement = 0;
+      descriptor_writes[j].descriptorCount = 1;
+      descriptor_writes[j].pBufferInfo = &buffer_infos[j];
+   }
+   descriptor_writes[0].dstSet = SceneDescriptorSet;
+   descriptor_writes[0].dstBinding = 0;
+   descriptor_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+   descriptor_writes[1].dstSet = SceneDescriptorSet;
+   descriptor_writes[1].dstBinding = 1;
+   descriptor_writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+   descriptor_writes[2].dstSet = ObjectDescriptorSet;
+   descriptor_writes[2].dstBinding = 0;
+   descriptor_writes[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+
+   vkUpdateDescriptorSets(
+      CommonVK::getDevice(),
+      static_cast<uint32_t>(descriptor_writes.size()),
+      descriptor_writes.data(),
+      0,
+      nullptr
+   );
+}
+
 void RendererVK::createObject()
 {
+   // All textures are requested before any descriptor set is written, so their decoding overlaps on the thread pool.
    UpperSquareObject = std::make_shared<ObjectVK>( Common.get() );
-   UpperSquareObject->setSquareObject( std::filesystem::path(CMAKE_SOURCE_DIR) / "emoy.png" );
-   UpperSquareObject->createDescriptorPool();
-   UpperSquareObject->createUniformBuffers();
-   UpperSquareObject->createDescriptorSets( Shader->getDescriptorSetLayout() );
+   UpperSquareObject->setSquareObject( std::filesystem::path(CMAKE_SOURCE_DIR) / "emoy.png", *TextureCache );
 
    LowerSquareObject = std::make_shared<ObjectVK>( Common.get() );
-   LowerSquareObject->setSquareObject( std::filesystem::path(CMAKE_SOURCE_DIR) / "emoy.png" );
-   LowerSquareObject->createDescriptorPool();
-   LowerSquareObject->createUniformBuffers();
-   LowerSquareObject->createDescriptorSets( Shader->getDescriptorSetLayout() );
+   LowerSquareObject->setSquareObject( std::filesystem::path(CMAKE_SOURCE_DIR) / "emoy.png", *TextureCache );
+
+   UpperSquareObject->createMaterialDescriptorSets( Shader->getMaterialDescriptorSetLayout() );
+   LowerSquareObject->createMaterialDescriptorSets( Shader->getMaterialDescriptorSetLayout() );
 }
 
 void RendererVK::createGraphicsPipeline()
 {
-   Shader = std::make_shared<ShaderVK>( Common.get() );
-   Shader->createRenderPass( SwapChainImageFormat );
-   Shader->createDescriptorSetLayout();
+   if (Shader == nullptr) {
+      Shader = std::make_shared<ShaderVK>( Common.get() );
+      Shader->createRenderPass( SwapChainImageFormat );
+      Shader->createDescriptorSetLayouts();
+   }
+#ifdef _DEBUG
+   const auto start = std::chrono::steady_clock::now();
+#endif
    Shader->createGraphicsPipeline(
       std::filesystem::path(CMAKE_SOURCE_DIR) / "shaders/shader.vert.spv",
       std::filesystem::path(CMAKE_SOURCE_DIR) / "shaders/shader.frag.spv",
       ObjectVK::getBindingDescription(),
-      ObjectVK::getAttributeDescriptions(),
-      { FrameWidth, FrameHeight }
+      ObjectVK::getAttributeDescriptions()
    );
+#ifdef _DEBUG
+   const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+   std::cout << "graphics pipeline created in " << elapsed.count() << " ms ("
+      << (CommonVK::isPipelineCacheWarm() ? "warm" : "cold") << " pipeline cache)\n";
+#endif
 }
 
 void RendererVK::createFramebuffers()
@@ -297,7 +436,7 @@ void RendererVK::createDepthResources()
       depth_format,
       VK_IMAGE_TILING_OPTIMAL,
       VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      MemoryAllocatorVK::Usage::GpuOnly,
       DepthImage,
       DepthImageMemory
    );
@@ -308,80 +447,42 @@ void RendererVK::createDepthResources()
    );
 }
 
-void RendererVK::copyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size)
-{
-   VkCommandBufferAllocateInfo allocate_info{};
-   allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-   allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-   allocate_info.commandPool = CommonVK::getCommandPool();
-   allocate_info.commandBufferCount = 1;
-
-   VkCommandBuffer command_buffer;
-   vkAllocateCommandBuffers( CommonVK::getDevice(), &allocate_info, &command_buffer );
-
-   VkCommandBufferBeginInfo begin_info{};
-   begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-   begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-   vkBeginCommandBuffer( command_buffer, &begin_info );
-      VkBufferCopy copy_region{};
-      copy_region.size = size;
-      vkCmdCopyBuffer(
-         command_buffer,
-         src_buffer, dst_buffer,
-         1, &copy_region
-      );
-   vkEndCommandBuffer( command_buffer );
-
-   VkSubmitInfo submit_info{};
-   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-   submit_info.commandBufferCount = 1;
-   submit_info.pCommandBuffers = &command_buffer;
-
-   vkQueueSubmit( CommonVK::getGraphicsQueue(), 1, &submit_info, VK_NULL_HANDLE );
-   vkQueueWaitIdle( CommonVK::getGraphicsQueue() );
-
-   vkFreeCommandBuffers(
-      CommonVK::getDevice(),
-      CommonVK::getCommandPool(),
-      1,
-      &command_buffer
-   );
-}
-
 void RendererVK::createVertexBuffer()
 {
-   VkBuffer staging_buffer;
-   VkDeviceMemory staging_buffer_memory;
    const VkDeviceSize buffer_size = LowerSquareObject->getVertexBufferSize();
-   CommonVK::createBuffer(
-      buffer_size,
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      staging_buffer,
-      staging_buffer_memory
-   );
-
-   void* data;
-   vkMapMemory(
-      CommonVK::getDevice(),
-      staging_buffer_memory,
-      0, buffer_size, 0, &data
-   );
-      memcpy( data, LowerSquareObject->getVertexData(), static_cast<size_t>(buffer_size) );
-   vkUnmapMemory( CommonVK::getDevice(), staging_buffer_memory );
+   const auto* vertex_data = static_cast<const uint8_t*>(LowerSquareObject->getVertexData());
+
+   // With unified memory, CpuToGpu lands in device-local memory, so the vertices are written in place and ticket 0
+   // counts as already acquired.
+   if (CommonVK::hasUnifiedMemory()) {
+      CommonVK::createBuffer(
+         buffer_size,
+         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+         MemoryAllocatorVK::Usage::CpuToGpu,
+         VertexBuffer,
+         VertexBufferMemory
+      );
+      std::memcpy( VertexBufferMemory.MappedData, vertex_data, static_cast<size_t>(buffer_size) );
+      VertexBufferUploadTicket = 0;
+      return;
+   }
 
+   const VkBufferUsageFlags usage =
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
    CommonVK::createBuffer(
       buffer_size,
-      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      usage,
+      MemoryAllocatorVK::Usage::GpuOnly,
       VertexBuffer,
       VertexBufferMemory
    );
-   copyBuffer( staging_buffer, VertexBuffer, buffer_size );
-
-   vkDestroyBuffer( CommonVK::getDevice(), staging_buffer, nullptr );
-   vkFreeMemory( CommonVK::getDevice(), staging_buffer_memory, nullptr );
+   VertexBufferUploadTicket = Uploader->uploadBuffer(
+      VertexBuffer,
+      std::vector<uint8_t>( vertex_data, vertex_data + buffer_size )
+   );
+   VertexBufferDefragmentationId = Defragmenter->registerBuffer(
+      VertexBuffer, VertexBufferMemory, buffer_size, usage, VertexBufferUploadTicket
+   );
 }
 
 void RendererVK::createCommandBuffer()
@@ -454,9 +555,27 @@ void RendererVK::initializeVulkan()
    Common->pickPhysicalDevice( Instance, Surface );
    Common->createLogicalDevice( Surface );
    Common->createCommandPool( Surface );
+   Common->createPipelineCache(
+      (std::filesystem::path(CMAKE_SOURCE_DIR) / "derived_data" / "pipeline_cache.bin").string()
+   );
+   Common->createPipelineRegistry();
+   Common->createAllocator();
+   Common->createDescriptorAllocator();
+   Uploader = std::make_unique<AsyncUploaderVK>( 16 * 1024 * 1024 );
+   ThreadPool = std::make_unique<ThreadPoolVK>( std::thread::hardware_concurrency() );
+   Defragmenter = std::make_unique<DefragmenterVK>( 32 * 1024 * 1024, 16 );
+   TextureCache = std::make_unique<TextureCacheVK>(
+      Uploader.get(),
+      ThreadPool.get(),
+      Defragmenter.get(),
+      true,
+      (std::filesystem::path(CMAKE_SOURCE_DIR) / "derived_data").string()
+   );
    createSwapChain();
    createImageViews();
    createGraphicsPipeline();
+   createUniformRingBuffer();
+   createSceneUniformBuffers();
    createObject();
    createDepthResources();
    createFramebuffers();
@@ -465,7 +584,7 @@ void RendererVK::initializeVulkan()
    createSyncObjects();
 }
 
-void RendererVK::recordCommandBuffer(VkCommandBuffer command_buffer, uint32_t image_index)
+uint64_t RendererVK::recordCommandBuffer(VkCommandBuffer command_buffer, uint32_t image_index)
 {
    VkCommandBufferBeginInfo begin_info{};
    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -474,6 +593,13 @@ void RendererVK::recordCommandBuffer(VkCommandBuffer command_buffer, uint32_t im
       throw std::runtime_error("failed to begin recording command buffer!");
    }
 
+   // Resources whose upload has been submitted change hands here; the submission waits for the returned timeline value.
+   const uint64_t upload_wait_value = Uploader->acquire( command_buffer );
+   if (++FramesSinceDefragmentation >= DefragmentationInterval) {
+      Defragmenter->recordMoves( command_buffer, Uploader->getAcquiredValue() );
+      FramesSinceDefragmentation = 0;
+   }
+
    VkRenderPassBeginInfo render_pass_info{};
    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
    render_pass_info.renderPass = Shader->getRenderPass();
@@ -497,6 +623,21 @@ void RendererVK::recordCommandBuffer(VkCommandBuffer command_buffer, uint32_t im
          VK_PIPELINE_BIND_POINT_GRAPHICS,
          Shader->getGraphicsPipeline()
       );
+
+      VkViewport viewport{};
+      viewport.x = 0.0f;
+      viewport.y = 0.0f;
+      viewport.width = static_cast<float>(SwapChainExtent.width);
+      viewport.height = static_cast<float>(SwapChainExtent.height);
+      viewport.minDepth = 0.0f;
+      viewport.maxDepth = 1.0f;
+      vkCmdSetViewport( command_buffer, 0, 1, &viewport );
+
+      VkRect2D scissor{};
+      scissor.offset = { 0, 0 };
+      scissor.extent = SwapChainExtent;
+      vkCmdSetScissor( command_buffer, 0, 1, &scissor );
+
       const std::array<VkBuffer, 1> vertex_buffers = { VertexBuffer };
       constexpr std::array<VkDeviceSize, 1> offsets = { 0 };
       vkCmdBindVertexBuffers(
@@ -509,31 +650,37 @@ void RendererVK::recordCommandBuffer(VkCommandBuffer command_buffer, uint32_t im
          VK_PIPELINE_BIND_POINT_GRAPHICS,
          Shader->getPipelineLayout(),
          0, 1,
-         LowerSquareObject->getDescriptorSet( CurrentFrame ),
+         &SceneDescriptorSet,
          0, nullptr
       );
-      vkCmdDraw(
-         command_buffer, LowerSquareObject->getVertexSize(),
-         1, 0, 0
-      );
-
-      vkCmdBindDescriptorSets(
-         command_buffer,
-         VK_PIPELINE_BIND_POINT_GRAPHICS,
-         Shader->getPipelineLayout(),
-         0, 1,
-         UpperSquareObject->getDescriptorSet( CurrentFrame ),
-         0, nullptr
-      );
-      vkCmdDraw(
-         command_buffer, UpperSquareObject->getVertexSize(),
-         1, 0, 0
-      );
+      for (const auto& object : { LowerSquareObject, UpperSquareObject }) {
+         if (!Uploader->isReady( VertexBufferUploadTicket ) || !Uploader->isReady( object->getUploadTicket() )) {
+            continue;
+         }
+
+         const std::array<VkDescriptorSet, 2> descriptor_sets = {
+            object->getMaterialDescriptorSet( CurrentFrame ),
+            ObjectDescriptorSet
+         };
+         vkCmdBindDescriptorSets(
+            command_buffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            Shader->getPipelineLayout(),
+            1, static_cast<uint32_t>(descriptor_sets.size()),
+            descriptor_sets.data(),
+            object->getDynamicOffsetSize(), object->getDynamicOffsets()
+         );
+         vkCmdDraw(
+            command_buffer, object->getVertexSize(),
+            1, 0, 0
+         );
+      }
    vkCmdEndRenderPass( command_buffer );
 
    if (vkEndCommandBuffer( command_buffer ) != VK_SUCCESS) {
       throw std::runtime_error( "failed to record command buffer!");
    }
+   return upload_wait_value;
 }
 
 void RendererVK::recreateSwapChain()
@@ -544,16 +691,59 @@ void RendererVK::recreateSwapChain()
       glfwGetFramebufferSize( Window, &width, &height );
       glfwWaitEvents();
    }
-   vkDeviceWaitIdle( CommonVK::getDevice() );
 
-   cleanupSwapChain();
+   // Nothing waits for the device here. Objects, textures, buffers and descriptor sets do not depend on the swap chain
+   // and are kept as they are, and what frames in flight may still use is retired to the deletion queue.
+   const VkFormat old_format = SwapChainImageFormat;
+   retireSwapChain();
    createSwapChain();
    createImageViews();
-   createGraphicsPipeline();
+   // The viewport is dynamic, so only a new image format, which needs a new render pass, changes the pipeline. The
+   // registry keeps the old ones alive for frames in flight and for a switch back to the old format.
+   if (SwapChainImageFormat != old_format) {
+      Shader->createRenderPass( SwapChainImageFormat );
+      createGraphicsPipeline();
+   }
    createDepthResources();
    createFramebuffers();
 }
 
+void RendererVK::updateSceneUniformBuffer()
+{
+   SceneUniformBufferObject scene{};
+   scene.View = glm::lookAt(
+      glm::vec3(0.0f, 0.0f, -2.0f),
+      glm::vec3(0.0f, 0.0f, 0.0f),
+      glm::vec3(0.0f, 1.0f, 0.0f)
+   );
+   scene.Projection = glm::perspective(
+      glm::radians( 45.0f ),
+      static_cast<float>(SwapChainExtent.width) / static_cast<float>(SwapChainExtent.height),
+      0.1f,
+      10.0f
+   );
+
+   // glm was originally designed for OpenGL, where the y-coordinate of the clip coordinates is inverted.
+   // The easiest way to compensate for that is to flip the sign on the scaling factor of the y-axis in the projection
+   // matrix. If you do not do this, then the image will be rendered upside down.
+   scene.Projection[1][1] *= -1;
+
+   LightUniformBufferObject light{};
+   light.Position = glm::vec4(0.5f, 0.5f, 2.5f, 0.0f);
+   light.AmbientColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+   light.DiffuseColor = glm::vec4(1.0f, 1.0f, 0.77f, 1.0f);
+   light.SpecularColor = glm::vec4(0.9f, 0.9f, 0.9f, 1.0f);
+   light.AttenuationFactors = glm::vec3(1.0f, 1.0f, 1.0f);
+   light.SpotlightDirection = glm::vec3(0.0f, 0.0f, -2.0f);
+   light.SpotlightCutoffAngle = 45.0f;
+   light.SpotlightFeather = 0.5f;
+   light.FallOffRadius = 1000.0f;
+
+   auto* mapped_data = static_cast<uint8_t*>(SceneUniformBuffersMemory[CurrentFrame].MappedData);
+   memcpy( mapped_data, &scene, sizeof( SceneUniformBufferObject ) );
+   memcpy( mapped_data + LightUniformOffset, &light, sizeof( LightUniformBufferObject ) );
+}
+
 void RendererVK::drawFrame()
 {
    vkWaitForFences(
@@ -563,6 +753,8 @@ void RendererVK::drawFrame()
       VK_TRUE,
       UINT64_MAX
    );
+   allocateFrameDescriptorSets();
+   flushDeletionQueue( true );
 
    uint32_t image_index;
    VkResult result = vkAcquireNextImageKHR(
@@ -593,20 +785,44 @@ void RendererVK::drawFrame()
       ) * glm::translate( glm::mat4(1.0f), glm::vec3(-0.5f, -0.5f, 0.0f) );
    const glm::mat4 upper_world =
       glm::translate( glm::mat4(1.0f), glm::vec3(0.5f, 0.0f, 0.0f) ) * lower_world;
-   LowerSquareObject->updateUniformBuffer( CurrentFrame, SwapChainExtent, lower_world );
-   UpperSquareObject->updateUniformBuffer( CurrentFrame, SwapChainExtent, upper_world );
+   // The copies of the last step were submitted with an earlier frame, so this one already sees the moved resources.
+   // Objects rewrite the descriptor set of each frame once its fence has signaled.
+   Defragmenter->completeMoves(
+      [this](std::function<void()> destroy) { deferDestruction( std::move( destroy ) ); }
+   );
+   updateSceneUniformBuffer();
+   UniformRing->beginFrame( CurrentFrame );
+   LowerSquareObject->updateUniformBuffer( *UniformRing, CurrentFrame, lower_world );
+   UpperSquareObject->updateUniformBuffer( *UniformRing, CurrentFrame, upper_world );
 
    vkResetFences( CommonVK::getDevice(), 1, &InFlightFences[CurrentFrame] );
    vkResetCommandBuffer( CommandBuffers[CurrentFrame], 0 );
-   recordCommandBuffer( CommandBuffers[CurrentFrame], image_index );
+   const uint64_t upload_wait_value = recordCommandBuffer( CommandBuffers[CurrentFrame], image_index );
 
    VkSubmitInfo submit_info{};
    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-   std::array<VkSemaphore, 1> wait_semaphores = { ImageAvailableSemaphores[CurrentFrame] };
+   std::array<VkSemaphore, 2> wait_semaphores = {
+      ImageAvailableSemaphores[CurrentFrame],
+      Uploader->getTimelineSemaphore()
+   };
    std::array<VkSemaphore, 1> signal_semaphores = { RenderFinishedSemaphores[CurrentFrame] };
-   std::array<VkPipelineStageFlags, 1> wait_stages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-   submit_info.waitSemaphoreCount = wait_semaphores.size();
+   std::array<VkPipelineStageFlags, 2> wait_stages = {
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      AsyncUploaderVK::getAcquireStages()
+   };
+
+   // The binary semaphores ignore their values; the timeline is only waited on when new uploads were acquired.
+   const std::array<uint64_t, 2> wait_values = { 0, upload_wait_value };
+   const std::array<uint64_t, 1> signal_values = { 0 };
+   submit_info.waitSemaphoreCount = upload_wait_value > 0 ? 2 : 1;
+   VkTimelineSemaphoreSubmitInfo timeline_info{};
+   timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+   timeline_info.waitSemaphoreValueCount = submit_info.waitSemaphoreCount;
+   timeline_info.pWaitSemaphoreValues = wait_values.data();
+   timeline_info.signalSemaphoreValueCount = signal_values.size();
+   timeline_info.pSignalSemaphoreValues = signal_values.data();
+   submit_info.pNext = &timeline_info;
    submit_info.pWaitSemaphores = wait_semaphores.data();
    submit_info.pWaitDstStageMask = wait_stages.data();
    submit_info.commandBufferCount = 1;
@@ -614,13 +830,13 @@ void RendererVK::drawFrame()
    submit_info.signalSemaphoreCount = signal_semaphores.size();
    submit_info.pSignalSemaphores = signal_semaphores.data();
 
-   result = vkQueueSubmit(
+   result = CommonVK::submitToQueue(
       CommonVK::getGraphicsQueue(),
-      1,
-      &submit_info,
+      submit_info,
       InFlightFences[CurrentFrame]
    );
    if (result != VK_SUCCESS) throw std::runtime_error("failed to submit draw command buffer!");
+   SubmittedFrames++;
 
    VkPresentInfoKHR present_info{};
    present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -631,7 +847,7 @@ void RendererVK::drawFrame()
    present_info.swapchainCount = swap_chains.size();
    present_info.pSwapchains = swap_chains.data();
    present_info.pImageIndices = &image_index;
-   result = vkQueuePresentKHR( CommonVK::getPresentQueue(), &present_info );
+   result = CommonVK::presentToQueue( present_info );
 
    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || FramebufferResized) {
       FramebufferResized = false;
@@ -667,7 +883,7 @@ void RendererVK::createInstance()
    application_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
    application_info.pEngineName = "No Engine";
    application_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-   application_info.apiVersion = VK_API_VERSION_1_0;
+   application_info.apiVersion = VK_API_VERSION_1_2;
 
    VkInstanceCreateInfo create_info{};
    create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -697,13 +913,13 @@ void RendererVK::createInstance()
 void RendererVK::writeFrame()
 {
    VkImage dst_image;
-   VkDeviceMemory dst_image_memory;
+   MemoryAllocatorVK::Allocation dst_image_memory;
    CommonVK::createImage(
-      FrameWidth, FrameHeight,
+      SwapChainExtent.width, SwapChainExtent.height,
       VK_FORMAT_R8G8B8A8_SRGB,
       VK_IMAGE_TILING_LINEAR,
       VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      MemoryAllocatorVK::Usage::GpuToCpu,
       dst_image,
       dst_image_memory
    );
@@ -739,8 +955,8 @@ void RendererVK::writeFrame()
    image_copy_region.srcSubresource.layerCount = 1;
    image_copy_region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
    image_copy_region.dstSubresource.layerCount = 1;
-   image_copy_region.extent.width = FrameWidth;
-   image_copy_region.extent.height = FrameHeight;
+   image_copy_region.extent.width = SwapChainExtent.width;
+   image_copy_region.extent.height = SwapChainExtent.height;
    image_copy_region.extent.depth = 1;
 
    vkCmdCopyImage(
@@ -789,25 +1005,21 @@ void RendererVK::writeFrame()
       &subresource_layout
    );
 
-   uint8_t* image_data;
-   vkMapMemory( CommonVK::getDevice(), dst_image_memory, 0, VK_WHOLE_SIZE, 0, (void**)&image_data);
-   image_data += subresource_layout.offset;
+   auto* image_data = static_cast<uint8_t*>(dst_image_memory.MappedData) + subresource_layout.offset;
 
    const std::string file_name = std::filesystem::path(CMAKE_SOURCE_DIR) / "frame.png";
    FIBITMAP* image = FreeImage_ConvertFromRawBits(
       image_data,
-      static_cast<int>(FrameWidth),
-      static_cast<int>(FrameHeight),
-      static_cast<int>(FrameWidth) * 4,
+      static_cast<int>(SwapChainExtent.width),
+      static_cast<int>(SwapChainExtent.height),
+      static_cast<int>(SwapChainExtent.width) * 4,
       32,
       FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, true
    );
    FreeImage_Save( FIF_PNG, image, file_name.c_str() );
    FreeImage_Unload( image );
 
-   vkUnmapMemory( CommonVK::getDevice(), dst_image_memory );
-   vkFreeMemory( CommonVK::getDevice(), dst_image_memory, nullptr );
-   vkDestroyImage( CommonVK::getDevice(), dst_image, nullptr );
+   CommonVK::destroyImage( dst_image, dst_image_memory );
 }
 
 void RendererVK::play()
@@ -815,10 +1027,21 @@ void RendererVK::play()
    initializeWindow();
    initializeVulkan();
 
+#ifdef _DEBUG
+   auto last_memory_report = std::chrono::steady_clock::now();
+#endif
    while (!glfwWindowShouldClose( Window )) {
       glfwPollEvents();
       drawFrame();
+#ifdef _DEBUG
+      const auto now = std::chrono::steady_clock::now();
+      if (now - last_memory_report >= MemoryReportInterval) {
+         CommonVK::getAllocator()->printHeapBudgets( std::cout );
+         std::cout << "defragmentation reclaimed " << Defragmenter->getBytesReclaimed() / 1024 << " KiB\n";
+         last_memory_report = now;
+      }
+#endif
    }
    writeFrame();
-   vkDeviceWaitIdle( CommonVK::getDevice() );
+   CommonVK::waitDeviceIdle();
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "staging_ring.h"
+
+StagingRingVK::StagingRingVK(VkDeviceSize size, VkSemaphore timeline_semaphore) :
+   Size( size ), Alignment( 16 ), Head( 0 ), Tail( 0 ), HasUncommittedData( false ),
+   TimelineSemaphore( timeline_semaphore ), Buffer( VK_NULL_HANDLE )
+{
+   // Offsets of buffer-to-image copies have to be a multiple of the texel size, which 16 covers for every format.
+   Alignment = std::max<VkDeviceSize>(
+      CommonVK::getPhysicalDeviceProperties().limits.optimalBufferCopyOffsetAlignment, Alignment
+   );
+
+   CommonVK::createBuffer(
+      Size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      MemoryAllocatorVK::Usage::Staging,
+      Buffer,
+      BufferMemory
+   );
+}
+
+StagingRingVK::~StagingRingVK()
+{
+   CommonVK::destroyBuffer( Buffer, BufferMemory );
+}
+
+bool StagingRingVK::tryAllocate(VkDeviceSize size, VkDeviceSize& offset)
+{
+   if (isEmpty()) Head = Tail = 0;
+
+   const VkDeviceSize aligned_head = (Head + Alignment - 1) / Alignment * Alignment;
+   const bool full = Head == Tail && !isEmpty();
+   if (Head >= Tail && !full) {
+      if (aligned_head + size <= Size) offset = aligned_head;
+      else if (size <= Tail) offset = 0;
+      else return false;
+   }
+   else if (aligned_head + size <= Tail) offset = aligned_head;
+   else return false;
+
+   Head = offset + size;
+   HasUncommittedData = true;
+   return true;
+}
+
+bool StagingRingVK::waitForOldestSubmission()
+{
+   if (Submissions.empty()) return false;
+
+   VkSemaphoreWaitInfo wait_info{};
+   wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+   wait_info.semaphoreCount = 1;
+   wait_info.pSemaphores = &TimelineSemaphore;
+   wait_info.pValues = &Submissions.front().TimelineValue;
+   vkWaitSemaphores( CommonVK::getDevice(), &wait_info, UINT64_MAX );
+   reclaim();
+   return true;
+}
+
+bool StagingRingVK::allocate(VkDeviceSize size, Region& region)
+{
+   if (size > Size) return false;
+
+   // When the ring is full, the oldest submission is waited for; once only the caller's own uncommitted data is left,
+   // waiting cannot help and the caller has to fall back to a temporary buffer.
+   VkDeviceSize offset = 0;
+   reclaim();
+   while (!tryAllocate( size, offset )) {
+      if (!waitForOldestSubmission()) return false;
+   }
+
+   region.Buffer = Buffer;
+   region.Offset = offset;
+   region.MappedData = static_cast<uint8_t*>(BufferMemory.MappedData) + offset;
+   return true;
+}
+
+void StagingRingVK::commit(uint64_t timeline_value)
+{
+   if (!HasUncommittedData) return;
+
+   Submissions.push_back( { timeline_value, Head } );
+   HasUncommittedData = false;
+}
+
+void StagingRingVK::reclaim()
+{
+   if (Submissions.empty()) return;
+
+   uint64_t completed_value = 0;
+   vkGetSemaphoreCounterValue( CommonVK::getDevice(), TimelineSemaphore, &completed_value );
+   while (!Submissions.empty() && Submissions.front().TimelineValue <= completed_value) {
+      Tail = Submissions.front().End;
+      Submissions.pop_front();
+   }
+}
\ No newline at end of file
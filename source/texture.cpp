@@ -0,0 +1,165 @@
+#include "texture.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TEXTURE_USE_SSE2
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TEXTURE_USE_NEON
+#endif
+
+TextureVK::TextureVK(ImageData image_data, AsyncUploaderVK& uploader, DefragmenterVK* defragmenter) :
+   Width( image_data.Width ), Height( image_data.Height ),
+   MipLevels( static_cast<uint32_t>(image_data.LevelOffsets.size()) ), Format( image_data.Format ), Image{},
+   ImageMemory{}, ImageView{}, Components( image_data.Components ), UploadTicket( 0 ), Defragmenter( defragmenter ),
+   DefragmentationId( 0 ), NextSubscription( 1 )
+{
+   const bool generate_mipmaps = MipLevels == 1 && !BlockCompressionVK::isBlockCompressed( Format );
+   if (generate_mipmaps) MipLevels = CommonVK::getMipLevelCount( Width, Height );
+   const bool blit_mipmaps = generate_mipmaps && CommonVK::supportsLinearBlit( Format );
+   VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+   if (blit_mipmaps || Defragmenter != nullptr) usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+   CommonVK::createImage(
+      Width, Height,
+      Format,
+      VK_IMAGE_TILING_OPTIMAL,
+      usage,
+      MemoryAllocatorVK::Usage::GpuOnly,
+      Image,
+      ImageMemory,
+      MipLevels
+   );
+
+   // Without linear blits for the format, the whole chain is built here and every level is copied.
+   if (generate_mipmaps && !blit_mipmaps) generateMipChain( image_data );
+   UploadTicket = uploader.uploadImage(
+      Image, std::move( image_data.Texels ), Width, Height, MipLevels, std::move( image_data.LevelOffsets )
+   );
+
+   ImageView = CommonVK::createImageView(
+      Image,
+      Format,
+      VK_IMAGE_ASPECT_COLOR_BIT,
+      MipLevels,
+      1,
+      Components
+   );
+
+   if (Defragmenter != nullptr) {
+      DefragmentationId = Defragmenter->registerImage(
+         Image, ImageMemory, Width, Height, Format, usage, MipLevels, UploadTicket,
+         [this](const DefragmenterVK::DeferDestruction& defer_destruction) {
+            const VkImageView old_view = ImageView;
+            defer_destruction( [old_view]() { vkDestroyImageView( CommonVK::getDevice(), old_view, nullptr ); } );
+            ImageView = CommonVK::createImageView( Image, Format, VK_IMAGE_ASPECT_COLOR_BIT, MipLevels, 1, Components );
+            for (const auto& subscriber : MoveSubscribers) subscriber.second();
+         }
+      );
+   }
+}
+
+TextureVK::~TextureVK()
+{
+   if (Defragmenter != nullptr) Defragmenter->unregister( DefragmentationId );
+   vkDestroyImageView( CommonVK::getDevice(), ImageView, nullptr );
+   CommonVK::destroyImage( Image, ImageMemory );
+}
+
+uint64_t TextureVK::subscribeToMoves(std::function<void()> on_moved)
+{
+   const uint64_t subscription = NextSubscription++;
+   MoveSubscribers.emplace( subscription, std::move( on_moved ) );
+   return subscription;
+}
+
+void TextureVK::unsubscribeFromMoves(uint64_t subscription)
+{
+   MoveSubscribers.erase( subscription );
+}
+
+void TextureVK::generateMipChain(ImageData& image_data)
+{
+   const bool srgb = image_data.Format == VK_FORMAT_R8G8B8A8_SRGB;
+   std::vector<uint8_t>& texels = image_data.Texels;
+   std::vector<VkDeviceSize>& level_offsets = image_data.LevelOffsets;
+   uint32_t level_width = image_data.Width;
+   uint32_t level_height = image_data.Height;
+   const uint32_t mip_levels = CommonVK::getMipLevelCount( level_width, level_height );
+   for (uint32_t level = 1; level < mip_levels; ++level) {
+      const uint32_t next_width = std::max( level_width / 2, 1u );
+      const uint32_t next_height = std::max( level_height / 2, 1u );
+      const VkDeviceSize src_offset = level_offsets.back();
+      level_offsets.emplace_back( static_cast<VkDeviceSize>(texels.size()) );
+      texels.resize( texels.size() + static_cast<size_t>(next_width) * next_height * 4 );
+      downsample( texels.data() + src_offset, level_width, level_height, srgb, texels.data() + level_offsets.back() );
+      level_width = next_width;
+      level_height = next_height;
+   }
+}
+
+// 2x2 box filter over RGBA8 texels. The last row and column are repeated when a dimension is odd or 1. sRGB color goes
+// through lookup tables, so only linear texels take the SIMD path; alpha is always stored linearly.
+void TextureVK::downsample(const uint8_t* src, uint32_t src_width, uint32_t src_height, bool srgb, uint8_t* dst)
+{
+   const std::array<uint16_t, 256>& decode = PixelConversionVK::getSRGBDecodeTable();
+   const std::vector<uint8_t>& encode = PixelConversionVK::getSRGBEncodeTable();
+   const uint32_t dst_width = std::max( src_width / 2, 1u );
+   const uint32_t dst_height = std::max( src_height / 2, 1u );
+   const size_t src_stride = static_cast<size_t>(src_width) * 4;
+   for (uint32_t y = 0; y < dst_height; ++y) {
+      const uint8_t* row0 = src + std::min( y * 2, src_height - 1 ) * src_stride;
+      const uint8_t* row1 = src + std::min( y * 2 + 1, src_height - 1 ) * src_stride;
+      uint8_t* dst_row = dst + static_cast<size_t>(y) * dst_width * 4;
+
+      uint32_t x = 0;
+#if defined(TEXTURE_USE_SSE2)
+      // Four destination texels per iteration, summed in 16 bits so that the rounding matches the scalar path.
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i rounding = _mm_set1_epi16( 2 );
+      for (; !srgb && x + 4 <= src_width / 2; x += 4) {
+         __m128i sums[2];
+         for (int half = 0; half < 2; ++half) {
+            const __m128i top = _mm_loadu_si128( reinterpret_cast<const __m128i*>(row0 + (x * 2 + half * 4) * 4) );
+            const __m128i bottom = _mm_loadu_si128( reinterpret_cast<const __m128i*>(row1 + (x * 2 + half * 4) * 4) );
+            const __m128i low = _mm_add_epi16( _mm_unpacklo_epi8( top, zero ), _mm_unpacklo_epi8( bottom, zero ) );
+            const __m128i high = _mm_add_epi16( _mm_unpackhi_epi8( top, zero ), _mm_unpackhi_epi8( bottom, zero ) );
+            const __m128i pairs = _mm_unpacklo_epi64(
+               _mm_add_epi16( low, _mm_srli_si128( low, 8 ) ),
+               _mm_add_epi16( high, _mm_srli_si128( high, 8 ) )
+            );
+            sums[half] = _mm_srli_epi16( _mm_add_epi16( pairs, rounding ), 2 );
+         }
+         _mm_storeu_si128( reinterpret_cast<__m128i*>(dst_row + x * 4), _mm_packus_epi16( sums[0], sums[1] ) );
+      }
+#elif defined(TEXTURE_USE_NEON)
+      // Eight destination texels per iteration: horizontal pairs are added while widening, and the rounding shift
+      // narrows the sums back to bytes.
+      for (; !srgb && x + 8 <= src_width / 2; x += 8) {
+         const uint8x16x4_t top = vld4q_u8( row0 + x * 8 );
+         const uint8x16x4_t bottom = vld4q_u8( row1 + x * 8 );
+         uint8x8x4_t averages;
+         for (int c = 0; c < 4; ++c) {
+            const uint16x8_t sums = vaddq_u16( vpaddlq_u8( top.val[c] ), vpaddlq_u8( bottom.val[c] ) );
+            averages.val[c] = vrshrn_n_u16( sums, 2 );
+         }
+         vst4_u8( dst_row + x * 4, averages );
+      }
+#endif
+      for (; x < dst_width; ++x) {
+         const size_t left = static_cast<size_t>(std::min( x * 2, src_width - 1 )) * 4;
+         const size_t right = static_cast<size_t>(std::min( x * 2 + 1, src_width - 1 )) * 4;
+         for (size_t c = 0; c < 4; ++c) {
+            if (srgb && c < 3) {
+               const uint32_t sum =
+                  decode[row0[left + c]] + decode[row0[right + c]] + decode[row1[left + c]] + decode[row1[right + c]];
+               dst_row[x * 4 + c] = encode[(sum + 2) / 4];
+               continue;
+            }
+            const uint32_t sum = row0[left + c] + row0[right + c] + row1[left + c] + row1[right + c];
+            dst_row[x * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+         }
+      }
+   }
+}
\ No newline at end of file
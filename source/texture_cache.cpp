@@ -0,0 +1,313 @@
+#include "texture_cache.h"
+
+TextureCacheVK::TextureCacheVK(
+   AsyncUploaderVK* uploader,
+   ThreadPoolVK* thread_pool,
+   DefragmenterVK* defragmenter,
+   bool deduplicate_by_content,
+   std::string derived_data_directory
+) :
+   Uploader( uploader ), ThreadPool( thread_pool ), Defragmenter( defragmenter ),
+   DeduplicateByContent( deduplicate_by_content ), PremultiplyAlpha( false ),
+   DerivedDataDirectory( std::move( derived_data_directory ) )
+{
+}
+
+uint64_t TextureCacheVK::getContentHash(const TextureVK::ImageData& image_data)
+{
+   // Hashes the format, the extent and the texels of every given level.
+   uint64_t hash = getFNVHash( &image_data.Format, sizeof( image_data.Format ) );
+   hash = getFNVHash( &image_data.Width, sizeof( image_data.Width ), hash );
+   hash = getFNVHash( &image_data.Height, sizeof( image_data.Height ), hash );
+   return getFNVHash( image_data.Texels.data(), image_data.Texels.size(), hash );
+}
+
+uint64_t TextureCacheVK::getFileHash(const std::string& file_path)
+{
+   std::ifstream file( file_path, std::ios::binary );
+   if (!file.is_open()) throw std::runtime_error("failed to open texture image!");
+
+   uint64_t hash = FNVOffsetBasis ^ DerivedDataVersion;
+   std::array<char, 64 * 1024> buffer{};
+   while (file) {
+      file.read( buffer.data(), static_cast<std::streamsize>(buffer.size()) );
+      hash = getFNVHash( buffer.data(), static_cast<size_t>(file.gcount()), hash );
+   }
+   return hash;
+}
+
+void TextureCacheVK::removeExpiredEntries()
+{
+   for (auto it = PathEntries.begin(); it != PathEntries.end();) {
+      if (it->second.expired()) it = PathEntries.erase( it );
+      else ++it;
+   }
+   for (auto it = ContentEntries.begin(); it != ContentEntries.end();) {
+      if (it->second.expired()) it = ContentEntries.erase( it );
+      else ++it;
+   }
+}
+
+TextureCacheVK::TextureFuture TextureCacheVK::loadAsync(const std::string& texture_file_path)
+{
+   std::error_code error;
+   std::string key = std::filesystem::weakly_canonical( texture_file_path, error ).string();
+   if (error) key = texture_file_path;
+
+   std::lock_guard<std::mutex> lock( Mutex );
+   const auto path_entry = PathEntries.find( key );
+   if (path_entry != PathEntries.end()) {
+      if (auto texture = path_entry->second.lock()) {
+         std::promise<std::shared_ptr<TextureVK>> loaded;
+         loaded.set_value( std::move( texture ) );
+         return loaded.get_future().share();
+      }
+   }
+   const auto pending_load = PendingLoads.find( key );
+   if (pending_load != PendingLoads.end()) return pending_load->second;
+   removeExpiredEntries();
+
+   TextureFuture future = ThreadPool->submit(
+      [this, key, texture_file_path]() {
+         try {
+            return create( key, decode( texture_file_path ) );
+         }
+         catch (...) {
+            std::lock_guard<std::mutex> failed_lock( Mutex );
+            PendingLoads.erase( key );
+            throw;
+         }
+      }
+   ).share();
+   PendingLoads.emplace( key, future );
+   return future;
+}
+
+TextureVK::ImageData TextureCacheVK::decode(const std::string& texture_file_path) const
+{
+   if (KTX2ReaderVK::isKTX2File( texture_file_path )) return KTX2ReaderVK( texture_file_path ).getImageData();
+   if (!DerivedDataDirectory.empty()) return loadCompressed( texture_file_path );
+   return loadWithFreeImage( texture_file_path );
+}
+
+std::shared_ptr<TextureVK> TextureCacheVK::create(const std::string& key, TextureVK::ImageData image_data)
+{
+   const uint64_t content_hash = DeduplicateByContent ? getContentHash( image_data ) : 0;
+
+   std::lock_guard<std::mutex> lock( Mutex );
+   std::shared_ptr<TextureVK> shared_texture;
+   if (DeduplicateByContent) {
+      const auto content_entry = ContentEntries.find( content_hash );
+      if (content_entry != ContentEntries.end()) shared_texture = content_entry->second.lock();
+   }
+   if (shared_texture == nullptr) {
+      shared_texture = std::make_shared<TextureVK>( std::move( image_data ), *Uploader, Defragmenter );
+      if (DeduplicateByContent) ContentEntries[content_hash] = shared_texture;
+   }
+   PathEntries[key] = shared_texture;
+   PendingLoads.erase( key );
+   return shared_texture;
+}
+
+TextureVK::ImageData TextureCacheVK::loadWithFreeImage(const std::string& texture_file_path) const
+{
+   const FREE_IMAGE_FORMAT format = FreeImage_GetFileType( texture_file_path.c_str(), 0 );
+   FIBITMAP* texture = FreeImage_Load( format, texture_file_path.c_str() );
+   if (texture == nullptr) throw std::runtime_error("failed to load texture image!");
+
+   TextureVK::ImageData image_data;
+   if (loadNarrowed( texture, image_data )) {
+      FreeImage_Unload( texture );
+      return image_data;
+   }
+
+   // 24 and 32-bit bitmaps are converted straight from the FreeImage rows; anything else goes through a 32-bit copy.
+   const uint n_bits_per_pixel = FreeImage_GetBPP( texture );
+   const bool direct =
+      FreeImage_GetImageType( texture ) == FIT_BITMAP && (n_bits_per_pixel == 24 || n_bits_per_pixel == 32);
+   FIBITMAP* texture_converted = direct ? texture : FreeImage_ConvertTo32Bits( texture );
+   if (texture_converted == nullptr) {
+      FreeImage_Unload( texture );
+      throw std::runtime_error("failed to convert texture image!");
+   }
+
+   image_data.Format = VK_FORMAT_R8G8B8A8_SRGB;
+   image_data.Width = FreeImage_GetWidth( texture_converted );
+   image_data.Height = FreeImage_GetHeight( texture_converted );
+   const auto* pixels = static_cast<const uint8_t*>(FreeImage_GetBits( texture_converted ));
+   if (pixels != nullptr) {
+      // FreeImage keeps the channels in BGR order on little-endian machines and in RGB order elsewhere.
+      constexpr bool bgr_order = FI_RGBA_RED == 2;
+      const bool has_alpha = FreeImage_GetBPP( texture_converted ) == 32;
+      const PixelConversionVK::Layout layout = has_alpha ?
+         (bgr_order ? PixelConversionVK::Layout::BGRA : PixelConversionVK::Layout::RGBA) :
+         (bgr_order ? PixelConversionVK::Layout::BGR : PixelConversionVK::Layout::RGB);
+      image_data.Texels.resize( static_cast<size_t>(image_data.Width) * image_data.Height * 4 );
+      PixelConversionVK::convertToRGBA(
+         layout,
+         pixels,
+         FreeImage_GetPitch( texture_converted ),
+         image_data.Width,
+         image_data.Height,
+         PremultiplyAlpha,
+         image_data.Texels.data()
+      );
+   }
+
+   if (texture_converted != texture) FreeImage_Unload( texture_converted );
+   FreeImage_Unload( texture );
+   if (pixels == nullptr) throw std::runtime_error("failed to load texture image!");
+   return image_data;
+}
+
+bool TextureCacheVK::isGray(
+   const uint8_t* pixels,
+   size_t pitch,
+   uint32_t width,
+   uint32_t height,
+   uint32_t channels,
+   bool& opaque
+)
+{
+   opaque = true;
+   for (uint32_t y = 0; y < height; ++y) {
+      const uint8_t* row = pixels + y * pitch;
+      for (uint32_t x = 0; x < width; ++x) {
+         const uint8_t* pixel = row + x * channels;
+         if (pixel[0] != pixel[1] || pixel[1] != pixel[2]) return false;
+         if (channels == 4) opaque = opaque && pixel[FI_RGBA_ALPHA] == 255;
+      }
+   }
+   return true;
+}
+
+// Keeps opaque 8-bit and 16-bit grayscale sources in a single channel instead of RGBA8, as long as the device can blit
+// the narrow format for the mip chain. The view swizzle expands them back to RGBA, so shaders sample them like any
+// other texture. Gray with alpha stays RGBA8, since no two-channel sRGB format keeps alpha linear, and 16-bit gray is
+// converted to linear because R16 has no sRGB variant.
+bool TextureCacheVK::loadNarrowed(FIBITMAP* bitmap, TextureVK::ImageData& image_data) const
+{
+   const auto* pixels = static_cast<const uint8_t*>(FreeImage_GetBits( bitmap ));
+   if (pixels == nullptr) return false;
+
+   const FREE_IMAGE_TYPE type = FreeImage_GetImageType( bitmap );
+   const uint n_bits_per_pixel = FreeImage_GetBPP( bitmap );
+   const uint32_t width = FreeImage_GetWidth( bitmap );
+   const uint32_t height = FreeImage_GetHeight( bitmap );
+   const size_t pitch = FreeImage_GetPitch( bitmap );
+
+   // Color bitmaps whose channels are all equal are reduced to their gray value.
+   uint32_t src_channels = 0;
+   VkFormat format;
+   if (type == FIT_UINT16) format = VK_FORMAT_R16_UNORM;
+   else if (type == FIT_BITMAP && n_bits_per_pixel == 8 && FreeImage_GetColorType( bitmap ) == FIC_MINISBLACK) {
+      format = VK_FORMAT_R8_SRGB;
+   }
+   else if (type == FIT_BITMAP && (n_bits_per_pixel == 24 || n_bits_per_pixel == 32)) {
+      src_channels = n_bits_per_pixel / 8;
+      bool opaque;
+      if (!isGray( pixels, pitch, width, height, src_channels, opaque ) || !opaque) return false;
+      format = VK_FORMAT_R8_SRGB;
+   }
+   else return false;
+   if (!CommonVK::supportsLinearBlit( format )) return false;
+
+   const uint32_t texel_size = format == VK_FORMAT_R8_SRGB ? 1 : 2;
+   image_data.Format = format;
+   image_data.Width = width;
+   image_data.Height = height;
+   image_data.Texels.resize( static_cast<size_t>(width) * height * texel_size );
+   image_data.Components = {
+      VK_COMPONENT_SWIZZLE_R,
+      VK_COMPONENT_SWIZZLE_R,
+      VK_COMPONENT_SWIZZLE_R,
+      VK_COMPONENT_SWIZZLE_ONE
+   };
+   for (uint32_t y = 0; y < height; ++y) {
+      const uint8_t* src_row = pixels + y * pitch;
+      uint8_t* dst_row = image_data.Texels.data() + static_cast<size_t>(y) * width * texel_size;
+      if (src_channels == 0) {
+         std::memcpy( dst_row, src_row, static_cast<size_t>(width) * texel_size );
+         if (format == VK_FORMAT_R16_UNORM) {
+            PixelConversionVK::decodeSRGB16( reinterpret_cast<uint16_t*>(dst_row), width );
+         }
+         continue;
+      }
+      for (uint32_t x = 0; x < width; ++x) dst_row[x] = src_row[x * src_channels];
+   }
+   return true;
+}
+
+VkFormat TextureCacheVK::getCompressedFormat(const TextureVK::ImageData& image_data)
+{
+   bool opaque = true;
+   for (size_t i = 3; i < image_data.Texels.size() && opaque; i += 4) opaque = image_data.Texels[i] == 255;
+
+   const std::vector<VkFormat> candidates = opaque ?
+      std::vector<VkFormat>{ VK_FORMAT_BC1_RGB_SRGB_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK } :
+      std::vector<VkFormat>{ VK_FORMAT_BC7_SRGB_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK };
+   for (const VkFormat format : candidates) {
+      const bool supported = CommonVK::isFormatSupported(
+         format,
+         VK_IMAGE_TILING_OPTIMAL,
+         VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT
+      );
+      if (supported) return format;
+   }
+   return VK_FORMAT_UNDEFINED;
+}
+
+TextureVK::ImageData TextureCacheVK::loadCompressed(const std::string& texture_file_path) const
+{
+   std::ostringstream file_name;
+   file_name << std::hex << std::setw( 16 ) << std::setfill( '0' ) << getFileHash( texture_file_path );
+   if (PremultiplyAlpha) file_name << "-premultiplied";
+   file_name << ".ktx2";
+   const std::string derived_file_path = (std::filesystem::path( DerivedDataDirectory ) / file_name.str()).string();
+   if (KTX2ReaderVK::isKTX2File( derived_file_path )) {
+      try {
+         return KTX2ReaderVK( derived_file_path ).getImageData();
+      }
+      catch (const std::exception& exception) {
+         std::cerr << "texture cache: " << exception.what() << " (" << derived_file_path << ")\n";
+      }
+   }
+
+   // Narrowed images are kept as they are, since the encoder only takes RGBA8 texels.
+   TextureVK::ImageData image_data = loadWithFreeImage( texture_file_path );
+   if (image_data.Format != VK_FORMAT_R8G8B8A8_SRGB) return image_data;
+
+   const VkFormat format = getCompressedFormat( image_data );
+   if (format == VK_FORMAT_UNDEFINED) return image_data;
+
+   TextureVK::generateMipChain( image_data );
+
+   TextureVK::ImageData compressed;
+   compressed.Format = format;
+   compressed.Width = image_data.Width;
+   compressed.Height = image_data.Height;
+   compressed.LevelOffsets.clear();
+   for (size_t level = 0; level < image_data.LevelOffsets.size(); ++level) {
+      const uint32_t level_width = std::max( image_data.Width >> level, 1u );
+      const uint32_t level_height = std::max( image_data.Height >> level, 1u );
+      compressed.LevelOffsets.emplace_back( static_cast<VkDeviceSize>(compressed.Texels.size()) );
+      const VkDeviceSize level_size = BlockCompressionVK::getLevelSize( format, level_width, level_height );
+      compressed.Texels.resize( compressed.Texels.size() + static_cast<size_t>(level_size) );
+      BlockCompressionVK::encode(
+         format,
+         image_data.Texels.data() + image_data.LevelOffsets[level],
+         level_width, level_height,
+         compressed.Texels.data() + compressed.LevelOffsets.back()
+      );
+   }
+
+   // The derived file only saves work on the next run, so failing to write it is not fatal.
+   try {
+      std::filesystem::create_directories( DerivedDataDirectory );
+      KTX2WriterVK::write( derived_file_path, compressed );
+   }
+   catch (const std::exception& exception) {
+      std::cerr << "texture cache: " << exception.what() << " (" << derived_file_path << ")\n";
+   }
+   return compressed;
+}
\ No newline at end of file
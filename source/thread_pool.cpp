@@ -0,0 +1,32 @@
+#include "thread_pool.h"
+
+ThreadPoolVK::ThreadPoolVK(uint32_t thread_count) : Stop( false )
+{
+   for (uint32_t i = 0; i < std::max( thread_count, 1u ); ++i) Workers.emplace_back( &ThreadPoolVK::run, this );
+}
+
+ThreadPoolVK::~ThreadPoolVK()
+{
+   {
+      std::lock_guard<std::mutex> lock( Mutex );
+      Stop = true;
+   }
+   Condition.notify_all();
+   for (auto& worker : Workers) worker.join();
+}
+
+void ThreadPoolVK::run()
+{
+   while (true) {
+      std::function<void()> job;
+      {
+         std::unique_lock<std::mutex> lock( Mutex );
+         Condition.wait( lock, [this]() { return Stop || !Jobs.empty(); } );
+         if (Jobs.empty()) return;
+
+         job = std::move( Jobs.front() );
+         Jobs.pop_front();
+      }
+      job();
+   }
+}
\ No newline at end of file
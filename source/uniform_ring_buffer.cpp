@@ -0,0 +1,47 @@
+#include "uniform_ring_buffer.h"
+
+UniformRingBufferVK::UniformRingBufferVK(VkDeviceSize size_per_frame) :
+   Alignment( 1 ), SizePerFrame( size_per_frame ), Head( 0 ), CurrentFrame( 0 )
+{
+   Alignment = std::max<VkDeviceSize>(
+      CommonVK::getPhysicalDeviceProperties().limits.minUniformBufferOffsetAlignment, 1
+   );
+
+   const int max_frames_in_flight = CommonVK::getMaxFramesInFlight();
+   Buffers.resize( max_frames_in_flight );
+   BuffersMemory.resize( max_frames_in_flight );
+   for (size_t i = 0; i < max_frames_in_flight; ++i) {
+      CommonVK::createBuffer(
+         SizePerFrame,
+         VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+         MemoryAllocatorVK::Usage::CpuToGpu,
+         Buffers[i],
+         BuffersMemory[i]
+      );
+   }
+}
+
+UniformRingBufferVK::~UniformRingBufferVK()
+{
+   for (size_t i = 0; i < Buffers.size(); ++i) {
+      CommonVK::destroyBuffer( Buffers[i], BuffersMemory[i] );
+   }
+}
+
+void UniformRingBufferVK::beginFrame(uint32_t frame_index)
+{
+   // The caller has already waited on this frame's fence, so everything written into its region is no longer read.
+   CurrentFrame = frame_index;
+   Head = 0;
+}
+
+uint32_t UniformRingBufferVK::push(const void* data, VkDeviceSize size)
+{
+   const VkDeviceSize offset = (Head + Alignment - 1) / Alignment * Alignment;
+   if (offset + size > SizePerFrame) throw std::runtime_error("uniform ring buffer is out of space for this frame!");
+
+   auto* mapped_data = static_cast<uint8_t*>(BuffersMemory[CurrentFrame].MappedData);
+   std::memcpy( mapped_data + offset, data, static_cast<size_t>(size) );
+   Head = offset + size;
+   return static_cast<uint32_t>(offset);
+}
\ No newline at end of file
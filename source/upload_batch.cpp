@@ -0,0 +1,311 @@
+#include "upload_batch.h"
+
+UploadBatchVK::UploadBatchVK(
+   VkCommandPool command_pool,
+   VkQueue queue,
+   uint32_t src_queue_family,
+   uint32_t dst_queue_family,
+   StagingRingVK* staging_ring
+) :
+   CommandPool( command_pool ), Queue( queue ), StagingRing( staging_ring ), SrcQueueFamily( src_queue_family ),
+   DstQueueFamily( dst_queue_family ),
+   CommandBuffer( VK_NULL_HANDLE ), TimelineSemaphore( VK_NULL_HANDLE ), SignalValue( 0 ), Submitted( false ),
+   HasBufferUploads( false )
+{
+}
+
+UploadBatchVK::~UploadBatchVK()
+{
+   if (Submitted) wait();
+   else if (CommandBuffer != VK_NULL_HANDLE) {
+      vkEndCommandBuffer( CommandBuffer );
+      release();
+   }
+}
+
+void UploadBatchVK::beginRecording()
+{
+   if (Submitted) throw std::runtime_error("failed to record into an upload batch that was already submitted!");
+   if (CommandBuffer != VK_NULL_HANDLE) return;
+
+   VkCommandBufferAllocateInfo allocate_info{};
+   allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+   allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+   allocate_info.commandPool = CommandPool;
+   allocate_info.commandBufferCount = 1;
+
+   VkResult result = vkAllocateCommandBuffers(
+      CommonVK::getDevice(),
+      &allocate_info,
+      &CommandBuffer
+   );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to allocate upload command buffer!");
+
+   VkCommandBufferBeginInfo begin_info{};
+   begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+   begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+   result = vkBeginCommandBuffer( CommandBuffer, &begin_info );
+   if (result != VK_SUCCESS) throw std::runtime_error("failed to begin recording upload command buffer!");
+}
+
+StagingRingVK::Region UploadBatchVK::stage(const void* data, VkDeviceSize size)
+{
+   StagingRingVK::Region region;
+   if (StagingRing != nullptr && StagingRing->allocate( size, region )) {
+      memcpy( region.MappedData, data, static_cast<size_t>(size) );
+      return region;
+   }
+
+   StagingBuffer staging_buffer;
+   CommonVK::createBuffer(
+      size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      MemoryAllocatorVK::Usage::Staging,
+      staging_buffer.Buffer,
+      staging_buffer.Memory
+   );
+   memcpy( staging_buffer.Memory.MappedData, data, static_cast<size_t>(size) );
+   StagingBuffers.emplace_back( staging_buffer );
+
+   region.Buffer = staging_buffer.Buffer;
+   region.MappedData = staging_buffer.Memory.MappedData;
+   return region;
+}
+
+void UploadBatchVK::uploadBuffer(VkBuffer dst_buffer, const void* data, VkDeviceSize size, VkDeviceSize dst_offset)
+{
+   beginRecording();
+   const StagingRingVK::Region staging_region = stage( data, size );
+
+   VkBufferCopy copy_region{};
+   copy_region.srcOffset = staging_region.Offset;
+   copy_region.dstOffset = dst_offset;
+   copy_region.size = size;
+   vkCmdCopyBuffer( CommandBuffer, staging_region.Buffer, dst_buffer, 1, &copy_region );
+   HasBufferUploads = true;
+
+   if (transfersOwnership()) {
+      VkBufferMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.dstAccessMask = 0;
+      barrier.srcQueueFamilyIndex = SrcQueueFamily;
+      barrier.dstQueueFamilyIndex = DstQueueFamily;
+      barrier.buffer = dst_buffer;
+      barrier.offset = dst_offset;
+      barrier.size = size;
+      vkCmdPipelineBarrier(
+         CommandBuffer,
+         VK_PIPELINE_STAGE_TRANSFER_BIT,
+         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+         0,
+         0, nullptr,
+         1, &barrier,
+         0, nullptr
+      );
+
+      barrier.srcAccessMask = 0;
+      barrier.dstAccessMask =
+         VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+      BufferAcquireBarriers.emplace_back( barrier );
+   }
+}
+
+void UploadBatchVK::uploadImage(
+   VkImage dst_image,
+   const void* data,
+   VkDeviceSize size,
+   uint32_t width,
+   uint32_t height,
+   uint32_t mip_levels,
+   const std::vector<VkDeviceSize>& level_offsets
+)
+{
+   const auto given_levels = static_cast<uint32_t>(level_offsets.size());
+   if (given_levels == 0 || given_levels > mip_levels || (given_levels > 1 && given_levels < mip_levels)) {
+      throw std::runtime_error("failed to upload an image with a partial mip chain!");
+   }
+   const bool generate_mipmaps = given_levels < mip_levels;
+
+   beginRecording();
+   const StagingRingVK::Region staging_region = stage( data, size );
+
+   VkImageSubresourceRange subresource_range{};
+   subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+   subresource_range.baseMipLevel = 0;
+   subresource_range.levelCount = mip_levels;
+   subresource_range.baseArrayLayer = 0;
+   subresource_range.layerCount = 1;
+
+   CommonVK::insertImageMemoryBarrier(
+      CommandBuffer,
+      dst_image,
+      0,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      subresource_range
+   );
+
+   std::vector<VkBufferImageCopy> regions( given_levels );
+   for (uint32_t level = 0; level < given_levels; ++level) {
+      VkBufferImageCopy& region = regions[level];
+      region.bufferOffset = staging_region.Offset + level_offsets[level];
+      region.bufferRowLength = 0;
+      region.bufferImageHeight = 0;
+      region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      region.imageSubresource.mipLevel = level;
+      region.imageSubresource.baseArrayLayer = 0;
+      region.imageSubresource.layerCount = 1;
+      region.imageOffset = { 0, 0, 0 };
+      region.imageExtent = { std::max( width >> level, 1u ), std::max( height >> level, 1u ), 1 };
+   }
+   vkCmdCopyBufferToImage(
+      CommandBuffer,
+      staging_region.Buffer,
+      dst_image,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      static_cast<uint32_t>(regions.size()),
+      regions.data()
+   );
+
+   if (!transfersOwnership()) {
+      if (generate_mipmaps) {
+         CommonVK::generateMipmaps( CommandBuffer, dst_image, width, height, mip_levels );
+         return;
+      }
+      CommonVK::insertImageMemoryBarrier(
+         CommandBuffer,
+         dst_image,
+         VK_ACCESS_TRANSFER_WRITE_BIT,
+         VK_ACCESS_SHADER_READ_BIT,
+         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+         VK_PIPELINE_STAGE_TRANSFER_BIT,
+         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+         subresource_range
+      );
+      return;
+   }
+
+   // The layout transition is part of the ownership transfer, so the release and the acquire barrier both describe it.
+   VkImageMemoryBarrier barrier{};
+   barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+   barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+   barrier.dstAccessMask = 0;
+   barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+   barrier.newLayout =
+      generate_mipmaps ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+   barrier.srcQueueFamilyIndex = SrcQueueFamily;
+   barrier.dstQueueFamilyIndex = DstQueueFamily;
+   barrier.image = dst_image;
+   barrier.subresourceRange = subresource_range;
+   vkCmdPipelineBarrier(
+      CommandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      0,
+      0, nullptr,
+      0, nullptr,
+      1, &barrier
+   );
+
+   barrier.srcAccessMask = 0;
+   barrier.dstAccessMask =
+      generate_mipmaps ? VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT;
+   ImageAcquireBarriers.emplace_back( barrier );
+   if (generate_mipmaps) MipmapGenerations.push_back( { dst_image, width, height, mip_levels } );
+}
+
+void UploadBatchVK::submit(VkSemaphore timeline_semaphore, uint64_t signal_value)
+{
+   if (Submitted || CommandBuffer == VK_NULL_HANDLE) return;
+   if (timeline_semaphore == VK_NULL_HANDLE) {
+      throw std::runtime_error("failed to submit an upload batch without a timeline semaphore!");
+   }
+
+   // One barrier covers every buffer copy of the batch instead of one per destination buffer.
+   if (HasBufferUploads && !transfersOwnership()) {
+      VkMemoryBarrier memory_barrier{};
+      memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      memory_barrier.dstAccessMask =
+         VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+      vkCmdPipelineBarrier(
+         CommandBuffer,
+         VK_PIPELINE_STAGE_TRANSFER_BIT,
+         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+         0,
+         1, &memory_barrier,
+         0, nullptr,
+         0, nullptr
+      );
+   }
+
+   if (vkEndCommandBuffer( CommandBuffer ) != VK_SUCCESS) {
+      throw std::runtime_error("failed to record upload command buffer!");
+   }
+
+   VkTimelineSemaphoreSubmitInfo timeline_info{};
+   timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+   timeline_info.signalSemaphoreValueCount = 1;
+   timeline_info.pSignalSemaphoreValues = &signal_value;
+
+   VkSubmitInfo submit_info{};
+   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+   submit_info.pNext = &timeline_info;
+   submit_info.commandBufferCount = 1;
+   submit_info.pCommandBuffers = &CommandBuffer;
+   submit_info.signalSemaphoreCount = 1;
+   submit_info.pSignalSemaphores = &timeline_semaphore;
+   if (CommonVK::submitToQueue( Queue, submit_info, VK_NULL_HANDLE ) != VK_SUCCESS) {
+      throw std::runtime_error("failed to submit upload command buffer!");
+   }
+   if (StagingRing != nullptr) StagingRing->commit( signal_value );
+   TimelineSemaphore = timeline_semaphore;
+   SignalValue = signal_value;
+   Submitted = true;
+}
+
+bool UploadBatchVK::isComplete()
+{
+   if (!Submitted) return CommandBuffer == VK_NULL_HANDLE;
+
+   uint64_t completed_value = 0;
+   vkGetSemaphoreCounterValue( CommonVK::getDevice(), TimelineSemaphore, &completed_value );
+   if (completed_value < SignalValue) return false;
+
+   release();
+   return true;
+}
+
+void UploadBatchVK::wait()
+{
+   if (!Submitted) return;
+
+   VkSemaphoreWaitInfo wait_info{};
+   wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+   wait_info.semaphoreCount = 1;
+   wait_info.pSemaphores = &TimelineSemaphore;
+   wait_info.pValues = &SignalValue;
+   vkWaitSemaphores( CommonVK::getDevice(), &wait_info, UINT64_MAX );
+   release();
+}
+
+void UploadBatchVK::release()
+{
+   VkDevice device = CommonVK::getDevice();
+   for (auto& staging_buffer : StagingBuffers) {
+      CommonVK::destroyBuffer( staging_buffer.Buffer, staging_buffer.Memory );
+   }
+   StagingBuffers.clear();
+
+   if (CommandBuffer != VK_NULL_HANDLE) vkFreeCommandBuffers( device, CommandPool, 1, &CommandBuffer );
+   CommandBuffer = VK_NULL_HANDLE;
+   TimelineSemaphore = VK_NULL_HANDLE;
+   Submitted = false;
+   HasBufferUploads = false;
+}
\ No newline at end of file